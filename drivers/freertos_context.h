@@ -0,0 +1,55 @@
+/*
+ * -----------------------------------------------------
+ *      __  __  _____  _____    _____
+ *     |  \/  ||_   _||  __ \  / ____|
+ *     | \  / |  | |  | |__) || (___
+ *     | |\/| |  | |  |  ___/  \___ \
+ *     | |  | | _| |_ | |      ____) |
+ *     |_|  |_||_____||_|     |_____/
+ * -----------------------------------------------------
+ * Copyright (c) 2025, MIPS All rights reserved.
+ * -----------------------------------------------------
+ */
+
+/**
+ * \file freertos_context.h
+ * \brief Execution context checks shared by the FreeRTOS drivers.
+ */
+
+#ifndef FREERTOS_CONTEXT_H
+#define FREERTOS_CONTEXT_H
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Machine interrupt enable bit of mstatus */
+#ifndef MSTATUS_MIE
+#define MSTATUS_MIE 0x8
+#endif
+
+/**
+ * \brief Non-zero if machine interrupts are enabled.
+ *
+ * MIE is clear in interrupt handlers, inside taskENTER_CRITICAL() and in
+ * code that disabled interrupts itself, e.g. on a crash.
+ */
+static inline int freertos_interrupts_enabled(void)
+{
+    uint32_t mstatus;
+
+    __asm__ volatile ("csrr %0, mstatus" : "=r" (mstatus));
+    return (mstatus & MSTATUS_MIE) != 0;
+}
+
+/**
+ * \brief Non-zero if the caller is a task that may block.
+ *
+ * Requires interrupts enabled and the scheduler running, neither
+ * suspended nor started yet.
+ */
+static inline int freertos_in_task_context(void)
+{
+    return freertos_interrupts_enabled() && xTaskGetSchedulerState() == taskSCHEDULER_RUNNING;
+}
+
+#endif /* FREERTOS_CONTEXT_H */
@@ -12,17 +12,82 @@
  */
 
 #include "log.h"
+#if LOG_ASYNC_MODE
+#include "log_ring.h"
+#endif
+#if LOG_CRASH_MODE
+#include "log_crash.h"
+#endif
+#if LOG_FLOAT_MODE
+#include "log_float.h"
+#endif
+#if LOG_STATS_MODE && !defined(LOG_STATS_CYCLES)
+#include "riscv_csr.h"
+/* The low 32 bits of mcycle are plenty for the length of one call */
+#define LOG_STATS_CYCLES() ((uint32_t)csr_read_mcycle())
+#endif
+
+#if LOG_STATS_MODE
+/* Counters behind log_stats_get(). Updated with relaxed atomics from any
+    context; the 64-bit total is kept as two words to stay lock-free on RV32 */
+static struct {
+    uint32_t records;
+    uint32_t bytes;
+    uint32_t truncated;
+    uint32_t dropped;
+    uint32_t prints;
+    uint32_t print_max_cycles;
+    uint32_t print_cycles_lo;
+    uint32_t print_cycles_hi;
+    uint32_t uart_max_cycles;
+} stats;
+
+#define LOG_STATS_ADD(field, value) __atomic_fetch_add(&stats.field, (value), __ATOMIC_RELAXED)
+
+static void log_stats_max(uint32_t* max, uint32_t value)
+{
+    uint32_t current = __atomic_load_n(max, __ATOMIC_RELAXED);
+    while (value > current &&
+           !__atomic_compare_exchange_n(max, &current, value, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+#else
+#define LOG_STATS_ADD(field, value) ((void)0)
+#endif
 
 static log_output_handler_t custom_output_handler = NULL;
 
+uint8_t log_module_levels[LOG_MODULE_COUNT] = {
+    [0 ... LOG_MODULE_COUNT - 1] = LOG_DEFAULT_LEVEL,
+};
+
+#define LOG_MODULE_NAME(name) #name,
+static const char* const log_module_names[LOG_MODULE_COUNT] = {
+    LOG_MODULE_LIST(LOG_MODULE_NAME)
+};
+#undef LOG_MODULE_NAME
+
+/* Bounds of the .logsite section, provided by linker.ld. Weak so images
+    linked without the section simply have no sites */
+extern log_site_t __log_sites_start[] __attribute__((weak));
+extern log_site_t __log_sites_end[] __attribute__((weak));
+
 __attribute__((weak)) void log_output_default(const char* message, size_t length)
 {
-    // Use UART to output the message
-    uart_puts(message);
+    // Use UART to output the message, a FIFO's worth per ready check;
+    // binary records may contain NUL bytes
+#if LOG_STATS_MODE
+    uint32_t start = LOG_STATS_CYCLES();
+    uart_write(message, length);
+    log_stats_max(&stats.uart_max_cycles, LOG_STATS_CYCLES() - start);
+#else
+    uart_write(message, length);
+#endif
 }
 
-static void log_output_internal(const char* message, size_t length)
+static void log_output_console(void* ctx, const char* message, size_t length)
 {
+    (void)ctx;
     if(custom_output_handler != NULL) {
         /* Use registered custom handler */
         custom_output_handler(message, length);
@@ -32,70 +97,883 @@ static void log_output_internal(const char* message, size_t length)
     }
 }
 
+static struct {
+    log_sink_handler_t handler;
+    void* ctx;
+    uint8_t level;
+    uint8_t encoding;
+} sinks[LOG_MAX_SINKS] = {
+    [LOG_SINK_CONSOLE] = { log_output_console, NULL, LOG_LEVEL_DEBUG, LOG_SINK_TEXT | LOG_SINK_BINARY },
+};
+
+int log_sink_add(log_sink_handler_t handler, void* ctx, int level, int encoding)
+{
+    for (int i = 0; i < LOG_MAX_SINKS; i++) {
+        if (sinks[i].handler == NULL) {
+            sinks[i].ctx = ctx;
+            sinks[i].level = level;
+            sinks[i].encoding = encoding;
+            /* Publish the handler last so the sink is never seen half set up */
+            __atomic_store_n(&sinks[i].handler, handler, __ATOMIC_RELEASE);
+            return i;
+        }
+    }
+    return -1;
+}
+
+void log_sink_remove(int sink)
+{
+    if (sink > LOG_SINK_CONSOLE && sink < LOG_MAX_SINKS) {
+        __atomic_store_n(&sinks[sink].handler, NULL, __ATOMIC_RELEASE);
+    }
+}
+
+void log_sink_set_level(int sink, int level)
+{
+    if (sink >= 0 && sink < LOG_MAX_SINKS) {
+        sinks[sink].level = level;
+    }
+}
+
+void log_output_direct(const char* message, size_t length, int attr)
+{
+    int level = attr & LOG_RECORD_LEVEL_MASK;
+    int encoding = (attr & LOG_RECORD_BINARY) ? LOG_SINK_BINARY : LOG_SINK_TEXT;
+
+    // Every sink gets the same bytes; nothing is formatted per sink
+    for (int i = 0; i < LOG_MAX_SINKS; i++) {
+        log_sink_handler_t handler = __atomic_load_n(&sinks[i].handler, __ATOMIC_ACQUIRE);
+        if (handler != NULL && sinks[i].level != LOG_LEVEL_OFF &&
+            level <= sinks[i].level && (sinks[i].encoding & encoding)) {
+            handler(sinks[i].ctx, message, length);
+        }
+    }
+}
+
+static void log_output_sink(const char* message, size_t length, int attr)
+{
+#if LOG_CRASH_MODE
+    /* Copied before the ring and the sink filters so it survives a reset */
+    log_crash_write(message, length);
+#endif
+#if LOG_ASYNC_MODE
+    /* Queue the record; log_ring_drain() hands it to the sinks */
+    if (log_ring_write(message, length, attr) != 0) {
+        LOG_STATS_ADD(dropped, 1);
+        return;
+    }
+#else
+    log_output_direct(message, length, attr);
+#endif
+    if (!(attr & LOG_RECORD_MORE)) {
+        LOG_STATS_ADD(records, 1);
+    }
+    LOG_STATS_ADD(bytes, length);
+}
+
+#if LOG_DEDUP_MODE
+/* Hash of the last record and the number of copies dropped since. Updated
+    with atomic exchanges so concurrent writers can at worst miscount */
+static uint32_t dedup_hash;
+static uint32_t dedup_repeats;
+
+// FNV-1a hash of a record, skipping the LOG_TIMESTAMP_MODE prefix
+static uint32_t log_record_hash(const char* message, size_t length)
+{
+    size_t i = 0;
+    uint32_t hash = 2166136261u;
+
+    if (LOG_TIMESTAMP_MODE && length > 2 && message[0] == '\n' && message[1] == '[') {
+        // "[%10llu] ": at least ten digits or pad spaces, then "] "
+        size_t end = 2;
+        while (end < length && (message[end] == ' ' || (message[end] >= '0' && message[end] <= '9'))) end++;
+        if (end >= 12 && end + 1 < length && message[end] == ']' && message[end + 1] == ' ') {
+            i = end + 2;
+        }
+    }
+    for (; i < length; i++) {
+        hash = (hash ^ (uint8_t)message[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Output the pending "last message repeated" note, if any
+static void log_dedup_note(void)
+{
+    uint32_t repeats = __atomic_exchange_n(&dedup_repeats, 0, __ATOMIC_RELAXED);
+    if (repeats > 0) {
+        char note[48];
+        size_t length = 0;
+        log_append_str(note, &length, sizeof(note), "\nlast message repeated ", -1);
+        log_append_num(note, &length, sizeof(note), repeats, 10, 0, 0, 0, 0);
+        log_append_str(note, &length, sizeof(note), " times", -1);
+        log_output_sink(note, length, LOG_LEVEL_OFF);
+    }
+}
+#endif
+
+static void log_output_internal(const char* message, size_t length, int attr)
+{
+#if LOG_DEDUP_MODE
+    if (attr & LOG_RECORD_MORE) {
+        /* Leading chunk of a long record; never a repeat, and clears the
+            hash so the final chunk is not compared against a record */
+        log_dedup_note();
+        __atomic_store_n(&dedup_hash, 0, __ATOMIC_RELAXED);
+        log_output_sink(message, length, attr);
+        return;
+    }
+    uint32_t hash = log_record_hash(message, length);
+    if (__atomic_exchange_n(&dedup_hash, hash, __ATOMIC_RELAXED) == hash) {
+        __atomic_fetch_add(&dedup_repeats, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    log_dedup_note();
+#endif
+    log_output_sink(message, length, attr);
+}
+
+void log_dedup_flush(void)
+{
+#if LOG_DEDUP_MODE
+    log_dedup_note();
+    __atomic_store_n(&dedup_hash, 0, __ATOMIC_RELAXED);
+#endif
+}
+
+void log_suppressed(uint32_t count)
+{
+    log_print("\n%u messages suppressed", (unsigned)count);
+}
+
+void log_stats_get(log_stats_t* out)
+{
+    memset(out, 0, sizeof(*out));
+#if LOG_STATS_MODE
+    uint32_t hi, lo;
+    do {
+        hi = __atomic_load_n(&stats.print_cycles_hi, __ATOMIC_RELAXED);
+        lo = __atomic_load_n(&stats.print_cycles_lo, __ATOMIC_RELAXED);
+    } while (hi != __atomic_load_n(&stats.print_cycles_hi, __ATOMIC_RELAXED));
+
+    out->records = __atomic_load_n(&stats.records, __ATOMIC_RELAXED);
+    out->bytes = __atomic_load_n(&stats.bytes, __ATOMIC_RELAXED);
+    out->truncated = __atomic_load_n(&stats.truncated, __ATOMIC_RELAXED);
+    out->dropped = __atomic_load_n(&stats.dropped, __ATOMIC_RELAXED);
+    out->prints = __atomic_load_n(&stats.prints, __ATOMIC_RELAXED);
+    out->print_max_cycles = __atomic_load_n(&stats.print_max_cycles, __ATOMIC_RELAXED);
+    out->print_cycles = ((uint64_t)hi << 32) | lo;
+    out->uart_max_cycles = __atomic_load_n(&stats.uart_max_cycles, __ATOMIC_RELAXED);
+#endif
+}
+
+void log_stats_reset(void)
+{
+#if LOG_STATS_MODE
+    memset(&stats, 0, sizeof(stats));
+#endif
+}
+
+void log_stats_truncated(void)
+{
+    LOG_STATS_ADD(truncated, 1);
+}
+
+uint32_t log_stats_print_start(void)
+{
+#if LOG_STATS_MODE
+    return LOG_STATS_CYCLES();
+#else
+    return 0;
+#endif
+}
+
+void log_stats_print_done(uint32_t start)
+{
+#if LOG_STATS_MODE
+    uint32_t cycles = LOG_STATS_CYCLES() - start;
+    if (__atomic_add_fetch(&stats.print_cycles_lo, cycles, __ATOMIC_RELAXED) < cycles) {
+        /* The low word wrapped */
+        LOG_STATS_ADD(print_cycles_hi, 1);
+    }
+    LOG_STATS_ADD(prints, 1);
+    log_stats_max(&stats.print_max_cycles, cycles);
+#else
+    (void)start;
+#endif
+}
+
+void log_stats_dump(void)
+{
+#if LOG_STATS_MODE
+    log_stats_t s;
+    log_stats_get(&s);
+    log_print("\nlog: %u records, %u bytes, %u truncated, %u dropped",
+              (unsigned)s.records, (unsigned)s.bytes, (unsigned)s.truncated, (unsigned)s.dropped);
+    log_print("\nlog: %u prints, %llu cycles, %u avg, %u max; uart_write %u max",
+              (unsigned)s.prints, (unsigned long long)s.print_cycles,
+              (unsigned)(s.prints ? s.print_cycles / s.prints : 0),
+              (unsigned)s.print_max_cycles, (unsigned)s.uart_max_cycles);
+#else
+    log_print("\nlog: statistics disabled, build with LOG_STATS_MODE=1");
+#endif
+}
+
+__attribute__((weak)) char* log_staging_acquire(size_t* size)
+{
+    (void)size;
+    return NULL;
+}
+
+__attribute__((weak)) void log_staging_commit(const char* record, size_t length, int attr)
+{
+    log_output_internal(record, length, attr);
+}
+
+void log_output_record(const char* message, size_t length, int attr)
+{
+    log_output_internal(message, length, attr);
+}
+
 void log_register_output_handler(log_output_handler_t handler)
 {
     custom_output_handler = handler;
 }
 
+void log_set_level(int module, int level)
+{
+    if (module == LOG_MODULE_ALL) {
+        for (int i = 0; i < LOG_MODULE_COUNT; i++) {
+            log_module_levels[i] = level;
+        }
+    } else if (module >= 0 && module < LOG_MODULE_COUNT) {
+        log_module_levels[module] = level;
+    } else {
+        return;
+    }
+
+    // Debug sites carry their own flag; keep it in step with the module
+    for (log_site_t* site = __log_sites_start; site < __log_sites_end; site++) {
+        if (module == LOG_MODULE_ALL || site->module == module) {
+            site->enabled = level >= LOG_LEVEL_DEBUG;
+        }
+    }
+}
+
+int log_site_enable(const char* file, int line, int enable)
+{
+    int matched = 0;
+
+    for (log_site_t* site = __log_sites_start; site < __log_sites_end; site++) {
+        if ((file == NULL || strcmp(site->file, file) == 0) &&
+            (line == 0 || site->line == line)) {
+            site->enabled = enable != 0;
+            matched++;
+        }
+    }
+    return matched;
+}
+
+int log_site_count(void)
+{
+    return __log_sites_end - __log_sites_start;
+}
+
+log_site_t* log_site_get(int index)
+{
+    if (index < 0 || index >= log_site_count()) {
+        return NULL;
+    }
+    return &__log_sites_start[index];
+}
+
+void log_site_dump(void)
+{
+    for (log_site_t* site = __log_sites_start; site < __log_sites_end; site++) {
+        LOG("\n%s:%d [%s] %c hits=%u", site->file, site->line,
+            log_module_names[site->module], site->enabled ? '+' : '-', (unsigned)site->hits);
+    }
+    LOG("\n");
+}
+
+int log_set_level_by_name(const char* name, int level)
+{
+    for (int i = 0; i < LOG_MODULE_COUNT; i++) {
+        if (strcmp(log_module_names[i], name) == 0) {
+            log_set_level(i, level);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int log_get_level(int module)
+{
+    if (module < 0 || module >= LOG_MODULE_COUNT) {
+        return LOG_LEVEL_OFF;
+    }
+    return log_module_levels[module];
+}
+
+const char* log_module_name(int module)
+{
+    if (module < 0 || module >= LOG_MODULE_COUNT) {
+        return NULL;
+    }
+    return log_module_names[module];
+}
+
 void log_init(void)
 {
     uart_init();
+#if LOG_CRASH_MODE
+    log_crash_init();
+#endif
     uart_puts("Logging system initialized.\n");
 }
 
 // Helper function to append a string to buffer
-static int append_str(char* buffer, size_t* offset, size_t max, const char* str, int precision)
+int log_append_str(char* buffer, size_t* offset, size_t max, const char* str, int precision)
 {
+    size_t pos = *offset;
+    size_t limit = max - 1 - pos;
     size_t i = 0;
-    while (str[i] && (precision < 0 || i < precision) && *offset < max - 1) {
-        buffer[(*offset)++] = str[i++];
+
+    // One bound for both the buffer space and the precision
+    if (precision >= 0 && (size_t)precision < limit) {
+        limit = precision;
+    }
+    while (i < limit && str[i]) {
+        buffer[pos + i] = str[i];
+        i++;
     }
+    *offset = pos + i;
     return i;
 }
 
-// Helper function to append a number (decimal or hex) to buffer
-static int append_num(char* buffer, size_t* offset, size_t max, unsigned long num, int base, int is_signed, int width, int zero_pad, int upper)
+/* "00" "01" ... "99": two digits per table lookup */
+static const char digit_pairs[200] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const char hex_lower[16] = "0123456789abcdef";
+static const char hex_upper[16] = "0123456789ABCDEF";
+
+// Upper 32 bits of a 32x32 multiply (a single mulhu on RV32IM)
+static inline uint32_t mulhu32(uint32_t a, uint32_t b)
 {
-    char temp[32];
-    int i = 0;
-    unsigned long n = num;
+#if defined(__riscv) && (__riscv_xlen == 32)
+    uint32_t hi;
+    __asm__ ("mulhu %0, %1, %2" : "=r" (hi) : "r" (a), "r" (b));
+    return hi;
+#else
+    return (uint32_t)(((uint64_t)a * b) >> 32);
+#endif
+}
+
+// n / 100 by reciprocal multiplication; exact for every 32-bit n
+static inline uint32_t div100(uint32_t n)
+{
+    return mulhu32(n, 0x51EB851Fu) >> 5;
+}
+
+// High 64 bits of the 128-bit product n * m, from 32-bit multiplies
+static uint64_t mulhi64(uint64_t n, uint64_t m)
+{
+    uint32_t n0 = (uint32_t)n, n1 = (uint32_t)(n >> 32);
+    uint32_t m0 = (uint32_t)m, m1 = (uint32_t)(m >> 32);
+
+    uint64_t p01 = ((uint64_t)mulhu32(n0, m1) << 32) | (uint32_t)(n0 * m1);
+    uint64_t p10 = ((uint64_t)mulhu32(n1, m0) << 32) | (uint32_t)(n1 * m0);
+    uint64_t p11 = ((uint64_t)mulhu32(n1, m1) << 32) | (uint32_t)(n1 * m1);
+    uint64_t mid = (uint64_t)mulhu32(n0, m0) + (uint32_t)p01 + (uint32_t)p10;
+    return p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+}
+
+// n / 10^8 by reciprocal multiplication, built from 32-bit multiplies
+// so RV32 needs neither a divide instruction nor __udivdi3
+static uint64_t div1e8(uint64_t n, uint32_t* rem)
+{
+    uint64_t q = mulhi64(n, 0xABCC77118461CEFDull) >> 26; /* ceil(2^90 / 10^8) */
+
+    *rem = (uint32_t)n - (uint32_t)q * 100000000u;
+    return q;
+}
 
-    if (is_signed && (long)num < 0) {
-        buffer[(*offset)++] = '-';
-        n = -(long)num;
+/* Microseconds per tick as a 0.64 fixed-point fraction, rounded up so whole
+    microseconds are exact. Long division in two 32-bit steps keeps it a
+    compile-time constant */
+#define LOG_TS_Q0 ((1000000ull << 32) / LOG_TIMESTAMP_HZ)
+#define LOG_TS_R0 ((1000000ull << 32) % LOG_TIMESTAMP_HZ)
+#define LOG_TIMESTAMP_MULT (((LOG_TS_Q0 << 32) | ((LOG_TS_R0 << 32) / LOG_TIMESTAMP_HZ)) + 1)
+
+__attribute__((weak)) uint64_t log_timestamp_raw(void)
+{
+#if defined(__riscv) && (__riscv_xlen == 32)
+    uint32_t hi, lo, hi2;
+    do {
+        __asm__ volatile ("csrr %0, mcycleh" : "=r"(hi));
+        __asm__ volatile ("csrr %0, mcycle" : "=r"(lo));
+        __asm__ volatile ("csrr %0, mcycleh" : "=r"(hi2));
+    } while (hi != hi2);
+    return ((uint64_t)hi << 32) | lo;
+#elif defined(__riscv)
+    uint64_t cycles;
+    __asm__ volatile ("csrr %0, mcycle" : "=r"(cycles));
+    return cycles;
+#else
+    return 0;
+#endif
+}
+
+uint64_t log_timestamp_us(void)
+{
+    return mulhi64(log_timestamp_raw(), LOG_TIMESTAMP_MULT);
+}
+
+// Write the decimal digits of n so they end at end; returns the first digit
+static char* format_dec32(char* end, uint32_t n)
+{
+    while (n >= 100) {
+        uint32_t q = div100(n);
+        end -= 2;
+        memcpy(end, &digit_pairs[(n - q * 100) * 2], 2);
+        n = q;
+    }
+    if (n >= 10) {
+        end -= 2;
+        memcpy(end, &digit_pairs[n * 2], 2);
+    } else {
+        *--end = '0' + n;
+    }
+    return end;
+}
+
+// Write exactly eight decimal digits of n (< 10^8) ending at end
+static char* format_dec8(char* end, uint32_t n)
+{
+    for (int i = 0; i < 4; i++) {
+        uint32_t q = div100(n);
+        end -= 2;
+        memcpy(end, &digit_pairs[(n - q * 100) * 2], 2);
+        n = q;
     }
+    return end;
+}
+
+static char* format_dec64(char* end, uint64_t n)
+{
+    uint32_t rem;
 
+    if ((n >> 32) == 0) {
+        return format_dec32(end, (uint32_t)n);
+    }
+    n = div1e8(n, &rem);
+    end = format_dec8(end, rem);
+    if ((n >> 32) != 0) {
+        n = div1e8(n, &rem);
+        end = format_dec8(end, rem);
+    }
+    return format_dec32(end, (uint32_t)n);
+}
+
+static char* format_hex64(char* end, uint64_t n, const char* digits)
+{
+    uint32_t lo = (uint32_t)n, hi = (uint32_t)(n >> 32);
+
+    if (hi != 0) {
+        for (int i = 0; i < 8; i++) {
+            *--end = digits[lo & 0xF];
+            lo >>= 4;
+        }
+        lo = hi;
+    }
     do {
-        int digit = n % base;
-        temp[i++] = (digit < 10) ? '0' + digit : (upper ? 'A' : 'a') + digit - 10;
-        n /= base;
-    } while (n && i < sizeof(temp));
+        *--end = digits[lo & 0xF];
+        lo >>= 4;
+    } while (lo);
+    return end;
+}
 
-    // Pad with zeros or spaces
-    while (i < width && *offset < max - 1) {
-        buffer[(*offset)++] = zero_pad ? '0' : ' ';
-        width--;
+// Helper function to append a number (decimal or hex) to buffer
+int log_append_num(char* buffer, size_t* offset, size_t max, uint64_t num, int base, int is_signed, int width, int zero_pad, int upper)
+{
+    char temp[24];
+    char* end = temp + sizeof(temp);
+    char* start;
+    size_t pos = *offset;
+    int negative = is_signed && (int64_t)num < 0;
+
+    if (negative) {
+        num = 0 - num;
     }
 
-    // Append digits in reverse order
-    while (i > 0 && *offset < max - 1) {
-        buffer[(*offset)++] = temp[--i];
+    if (base == 16) {
+        start = format_hex64(end, num, upper ? hex_upper : hex_lower);
+    } else {
+        start = format_dec64(end, num);
     }
-    return i;
+
+    int digits = end - start;
+    int pad = width - digits - negative;
+
+    // Spaces go before the sign, zeros after it
+    while (!zero_pad && pad > 0 && pos < max - 1) {
+        buffer[pos++] = ' ';
+        pad--;
+    }
+    if (negative && pos < max - 1) {
+        buffer[pos++] = '-';
+    }
+    while (pad > 0 && pos < max - 1) {
+        buffer[pos++] = '0';
+        pad--;
+    }
+
+    // Append digits
+    if ((size_t)digits > max - 1 - pos) {
+        digits = max - 1 - pos;
+    }
+    memcpy(&buffer[pos], start, digits);
+    pos += digits;
+
+    int appended = pos - *offset;
+    *offset = pos;
+    return appended;
 }
 
-void log_print(const char* fmt, ...)
+/* Argument source for the formatter: a variadic call or pre-encoded words */
+typedef struct {
+    va_list ap;
+    const log_word_t* words;
+} log_args_t;
+
+// Size of the integer argument selected by a length modifier
+static size_t log_int_size(char length)
+{
+    switch (length) {
+        case 'L': return sizeof(long long);
+        case 'l': return sizeof(long);
+        case 'z': return sizeof(size_t);
+        case 'j': return sizeof(intmax_t);
+        case 't': return sizeof(ptrdiff_t);
+        case 'h': return sizeof(short);
+        case 'H': return sizeof(char);
+        default:  return sizeof(int);
+    }
+}
+
+// Fetch an integer argument according to its length modifier
+static uint64_t log_fetch_int(log_args_t* args, char length, int is_signed)
+{
+    size_t size = log_int_size(length);
+    uint64_t value;
+
+    if (args->words != NULL) {
+        /* Pre-encoded: values wider than a word take two, low word first */
+        value = *args->words++;
+        if (size > sizeof(log_word_t)) {
+            value |= (uint64_t)*args->words++ << 32;
+        }
+    } else if (size == sizeof(uint64_t)) {
+        value = va_arg(args->ap, uint64_t);
+    } else {
+        value = va_arg(args->ap, unsigned int);
+    }
+
+    if (size < sizeof(uint64_t)) {
+        /* Truncate to the argument size, then sign extend if needed */
+        uint64_t sign = 1ull << (size * 8 - 1);
+        value &= (sign << 1) - 1;
+        if (is_signed) {
+            value = (value ^ sign) - sign;
+        }
+    }
+    return value;
+}
+
+static const void* log_fetch_ptr(log_args_t* args)
+{
+    if (args->words != NULL) {
+        return (const void*)*args->words++;
+    }
+    return va_arg(args->ap, const void*);
+}
+
+#if LOG_FLOAT_MODE
+static double log_fetch_double(log_args_t* args)
+{
+    if (args->words != NULL) {
+        /* Pre-encoded as the 64-bit pattern, like a long long */
+        uint64_t bits = log_fetch_int(args, 'L', 0);
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    return va_arg(args->ap, double);
+}
+#endif
+
+/*
+ * Output buffer of the formatter. When the buffer fills up and commit is set,
+ * the text so far is committed as a chunk flagged LOG_RECORD_MORE and the
+ * buffer is reused, so records of any length pass through a fixed buffer.
+ * Without commit the record is truncated to the buffer instead, and
+ * truncated is set once output has actually been lost.
+ */
+typedef struct {
+    char* buffer;
+    size_t max;
+    size_t offset;
+    int attr;
+    int truncated;
+    void (*commit)(const char* record, size_t length, int attr);
+} log_stream_t;
+
+// Commit the buffered chunk; returns zero if the record has to be truncated.
+// Only called with output pending that does not fit
+static __attribute__((noinline)) int log_stream_flush(log_stream_t* stream)
 {
-    va_list args;
-    char buffer[128];
-    size_t offset = 0;
+    if (stream->commit == NULL) {
+        stream->truncated = 1;
+        return 0;
+    }
+    if (stream->offset > 0) {
+        stream->commit(stream->buffer, stream->offset, stream->attr | LOG_RECORD_MORE);
+        stream->offset = 0;
+    }
+    return 1;
+}
 
-    va_start(args, fmt);
+static inline void log_stream_putc(log_stream_t* stream, char c)
+{
+    if (stream->offset < stream->max - 1 || log_stream_flush(stream)) {
+        stream->buffer[stream->offset++] = c;
+    }
+}
+
+static void log_stream_puts(log_stream_t* stream, const char* str, int precision)
+{
+    for (;;) {
+        int appended = log_append_str(stream->buffer, &stream->offset, stream->max, str, precision);
+        str += appended;
+        if (precision >= 0) {
+            precision -= appended;
+        }
+        if (*str == '\0' || precision == 0 || !log_stream_flush(stream)) {
+            break;
+        }
+    }
+}
 
+static void log_stream_num(log_stream_t* stream, uint64_t num, int base, int is_signed, int width, int zero_pad, int upper)
+{
+    size_t need = (width > LOG_NUM_MAX) ? (size_t)width : LOG_NUM_MAX;
+    size_t space = stream->max - 1 - stream->offset;
+
+    if (need > space && stream->commit == NULL) {
+        /* need is an upper bound; see whether this number really is cut */
+        char temp[LOG_NUM_MAX + 1];
+        size_t digits = 0;
+        log_append_num(temp, &digits, sizeof(temp), num, base, is_signed, 0, 0, upper);
+        if (digits > space || (width > 0 && (size_t)width > space)) {
+            stream->truncated = 1;
+        }
+    } else if (need > space && log_stream_flush(stream) && need > stream->max - 1) {
+        /* Padding wider than the whole buffer: pad one character at a time */
+        char temp[LOG_NUM_MAX + 1];
+        size_t digits = 0;
+        int pad = width - log_append_num(temp, &digits, sizeof(temp), num, base, is_signed, 0, 0, upper);
+        const char* text = temp;
+
+        if (zero_pad && temp[0] == '-') {
+            log_stream_putc(stream, *text++);
+        }
+        while (pad-- > 0) {
+            log_stream_putc(stream, zero_pad ? '0' : ' ');
+        }
+        log_stream_puts(stream, text, digits - (text - temp));
+        return;
+    }
+    log_append_num(stream->buffer, &stream->offset, stream->max, num, base, is_signed, width, zero_pad, upper);
+}
+
+#if LOG_FLOAT_MODE
+/*
+ * Round the digits d.ddd x 10^exponent of value to keep significant digits,
+ * as printf() does from the exact binary value. The shortest round-trip
+ * digits are enough unless the first dropped digit is a final 5: then the
+ * value may lie on either side of the tie (2.675 is 2.67499..., 0.05 is
+ * 0.05000...28), so it is compared exactly, and only a true tie rounds half
+ * to even. Digits past the shortest form still print as zeros.
+ */
+static void log_float_round(double value, char* digits, int* count, int* exponent, int keep)
+{
+    if (keep >= *count) {
+        return;
+    }
+
+    int up = 0;
+    if (keep >= 0) {
+        char next = digits[keep];
+        if (next != '5' || keep + 1 < *count) {
+            up = next >= '5';
+        } else {
+            int side = log_float_compare(value, digits, *count, *exponent);
+            int odd = (keep > 0) && ((digits[keep - 1] - '0') & 1);
+            up = side > 0 || (side == 0 && odd);
+        }
+    }
+
+    *count = (keep > 0) ? keep : 0;
+    if (up) {
+        int i = keep - 1;
+        while (i >= 0 && digits[i] == '9') {
+            i--;
+        }
+        if (i < 0) {
+            /* 9.99 -> 10.0, or rounding up from below the first digit */
+            digits[0] = '1';
+            *count = 1;
+            (*exponent)++;
+        } else {
+            digits[i]++;
+            *count = i + 1;
+        }
+    } else {
+        while (*count > 0 && digits[*count - 1] == '0') {
+            (*count)--;
+        }
+    }
+    if (*count == 0) {
+        *exponent = 0;
+    }
+}
+
+static void log_stream_float(log_stream_t* stream, double value, char conv, int width, int zero_pad, int precision)
+{
+    char digits[LOG_FLOAT_DIGITS];
+    int count = 0;
+    int exponent = 0;
+    int upper = (conv >= 'A' && conv <= 'Z');
+    char style = conv | 0x20;
+    int negative = __builtin_signbit(value) != 0;
+
+    if (__builtin_isnan(value) || __builtin_isinf(value)) {
+        const char* text = __builtin_isnan(value) ? (upper ? "NAN" : "nan") : (upper ? "INF" : "inf");
+        negative = negative && !__builtin_isnan(value);
+        for (int pad = width - 3 - negative; pad > 0; pad--) {
+            log_stream_putc(stream, ' ');
+        }
+        if (negative) {
+            log_stream_putc(stream, '-');
+        }
+        log_stream_puts(stream, text, -1);
+        return;
+    }
+
+    if (precision < 0) {
+        precision = 6;
+    }
+    if (value != 0.0) {
+        count = log_float_digits(value, digits, &exponent);
+    }
+
+    // Round to the precision; %g picks its style from the rounded exponent
+    if (style == 'g') {
+        int significant = precision ? precision : 1;
+        log_float_round(value, digits, &count, &exponent, significant);
+        if (exponent < significant && exponent >= -4) {
+            style = 'f';
+            precision = (count - 1 - exponent > 0) ? count - 1 - exponent : 0;
+        } else {
+            style = 'e';
+            precision = (count > 1) ? count - 1 : 0;
+        }
+    } else if (style == 'e') {
+        log_float_round(value, digits, &count, &exponent, precision + 1);
+    } else {
+        log_float_round(value, digits, &count, &exponent, exponent + 1 + precision);
+    }
+
+    int length = negative + (precision > 0 ? precision + 1 : 0);
+    int top = 0;
+    unsigned magnitude = 0;
+    if (style == 'f') {
+        top = (exponent > 0) ? exponent : 0;
+        length += top + 1;
+    } else {
+        magnitude = (exponent < 0) ? -exponent : exponent;
+        length += 1 + 2 + (magnitude >= 100 ? 3 : 2);
+    }
+
+    int pad = width - length;
+    while (!zero_pad && pad > 0) {
+        log_stream_putc(stream, ' ');
+        pad--;
+    }
+    if (negative) {
+        log_stream_putc(stream, '-');
+    }
+    while (pad > 0) {
+        log_stream_putc(stream, '0');
+        pad--;
+    }
+
+    // Digit i of d.ddd, or a zero past the last one
+#define LOG_FLOAT_DIGIT(i) (((i) >= 0 && (i) < count) ? digits[i] : '0')
+    if (style == 'f') {
+        for (int pos = top; pos >= -precision; pos--) {
+            if (pos == -1) {
+                log_stream_putc(stream, '.');
+            }
+            log_stream_putc(stream, LOG_FLOAT_DIGIT(exponent - pos));
+        }
+    } else {
+        log_stream_putc(stream, LOG_FLOAT_DIGIT(0));
+        if (precision > 0) {
+            log_stream_putc(stream, '.');
+            for (int i = 1; i <= precision; i++) {
+                log_stream_putc(stream, LOG_FLOAT_DIGIT(i));
+            }
+        }
+        log_stream_putc(stream, upper ? 'E' : 'e');
+        log_stream_putc(stream, (exponent < 0) ? '-' : '+');
+        log_stream_num(stream, magnitude, 10, 0, 2, 1, 0);
+    }
+#undef LOG_FLOAT_DIGIT
+}
+#endif
+
+// Format a record into the stream; the last chunk is left in the buffer, NUL terminated
+static void log_format(log_stream_t* stream, const char* fmt, log_args_t* args)
+{
     // Process the format string
-    while (*fmt && offset < sizeof(buffer) - 1) {
+    while (*fmt) {
         if (*fmt != '%') {
-            buffer[offset++] = *fmt++;
+            // Copy the run of literal text up to the next conversion
+            char* buffer = stream->buffer;
+            size_t offset = stream->offset;
+            size_t last = stream->max - 1;
+            do {
+                if (offset >= last) {
+                    stream->offset = offset;
+                    if (!log_stream_flush(stream)) {
+                        goto truncated;
+                    }
+                    offset = 0;
+                }
+                buffer[offset++] = *fmt++;
+            } while (*fmt && *fmt != '%');
+            stream->offset = offset;
             continue;
         }
 
@@ -126,71 +1004,190 @@ void log_print(const char* fmt, ...)
             }
         }
 
+        // Parse length modifier; h and hh arguments arrive promoted to int
+        // and are cut back to short and char by log_fetch_int()
+        char length = 0;
+        if (*fmt == 'l' || *fmt == 'z' || *fmt == 'j' || *fmt == 't' || *fmt == 'h') {
+            length = *fmt++;
+            if (length == 'l' && *fmt == 'l') {
+                length = 'L';
+                fmt++;
+            } else if (length == 'h' && *fmt == 'h') {
+                length = 'H';
+                fmt++;
+            }
+        }
+
         // Handle format specifier
         switch (*fmt) {
             case 's': {
-                const char* str = va_arg(args, const char*);
+                const char* str = log_fetch_ptr(args);
                 if (!str) str = "(null)";
-                append_str(buffer, &offset, sizeof(buffer), str, precision);
+                log_stream_puts(stream, str, precision);
                 fmt++;
                 break;
             }
             case 'd':
             case 'i': {
-                int num = va_arg(args, int);
-                append_num(buffer, &offset, sizeof(buffer), num, 10, 1, width, zero_pad, 0);
+                uint64_t num = log_fetch_int(args, length, 1);
+                log_stream_num(stream, num, 10, 1, width, zero_pad, 0);
                 fmt++;
                 break;
             }
             case 'u': {
-                unsigned int num = va_arg(args, unsigned int);
-                append_num(buffer, &offset, sizeof(buffer), num, 10, 0, width, zero_pad, 0);
+                uint64_t num = log_fetch_int(args, length, 0);
+                log_stream_num(stream, num, 10, 0, width, zero_pad, 0);
                 fmt++;
                 break;
             }
             case 'x':
             case 'X': {
-                unsigned int num = va_arg(args, unsigned int);
-                append_num(buffer, &offset, sizeof(buffer), num, 16, 0, width, zero_pad, (*fmt == 'X'));
+                uint64_t num = log_fetch_int(args, length, 0);
+                log_stream_num(stream, num, 16, 0, width, zero_pad, (*fmt == 'X'));
                 fmt++;
                 break;
             }
             case 'p': {
-                unsigned long num = (unsigned long)va_arg(args, void*);
-                append_str(buffer, &offset, sizeof(buffer), "0x", -1);
-                append_num(buffer, &offset, sizeof(buffer), num, 16, 0, width, 1, 0);
+                uintptr_t num = (uintptr_t)log_fetch_ptr(args);
+                log_stream_puts(stream, "0x", -1);
+                log_stream_num(stream, num, 16, 0, width, 1, 0);
                 fmt++;
                 break;
             }
+#if LOG_FLOAT_MODE
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G': {
+                double value = log_fetch_double(args);
+                log_stream_float(stream, value, *fmt, width, zero_pad, precision);
+                fmt++;
+                break;
+            }
+#endif
             case 'c': {
-                int c = va_arg(args, int);
-                if (offset < sizeof(buffer) - 1) {
-                    buffer[offset++] = (char)c;
-                }
+                int c = (int)log_fetch_int(args, 0, 1);
+                log_stream_putc(stream, (char)c);
                 fmt++;
                 break;
             }
             case '%':
-                if (offset < sizeof(buffer) - 1) {
-                    buffer[offset++] = '%';
-                }
+                log_stream_putc(stream, '%');
                 fmt++;
                 break;
             default:
                 // Unknown specifier, output as-is
-                if (offset < sizeof(buffer) - 1) {
-                    buffer[offset++] = '%';
-                    buffer[offset++] = *fmt++;
+                if (*fmt) {
+                    log_stream_putc(stream, '%');
+                    log_stream_putc(stream, *fmt++);
                 }
                 break;
         }
     }
 
-    buffer[offset] = '\0';
-    va_end(args);
+truncated:
+    stream->buffer[stream->offset] = '\0';
+}
+
+size_t log_vformat(char* buffer, size_t max, const char* fmt, va_list ap)
+{
+    log_args_t args = { .words = NULL };
+    log_stream_t stream = { .buffer = buffer, .max = max };
+
+    if (max == 0) {
+        return 0;
+    }
+    va_copy(args.ap, ap);
+    log_format(&stream, fmt, &args);
+    va_end(args.ap);
+    return stream.offset;
+}
+
+size_t log_format_words(char* buffer, size_t max, const char* fmt, const log_word_t* words)
+{
+    log_args_t args = { .words = words };
+    log_stream_t stream = { .buffer = buffer, .max = max };
+
+    if (max == 0) {
+        return 0;
+    }
+    log_format(&stream, fmt, &args);
+    if (stream.truncated) {
+        LOG_STATS_ADD(truncated, 1);
+    }
+    return stream.offset;
+}
+
+// Format and commit a record, in chunks of the buffer size if it is longer
+static void log_format_record(char* buffer, size_t max, int level, const char* fmt, log_args_t* args,
+                              void (*commit)(const char*, size_t, int))
+{
+    log_stream_t stream = {
+        .buffer = buffer,
+        .max = max,
+        .attr = level,
+        .commit = commit,
+    };
+
+    log_format(&stream, fmt, args);
+    if (stream.offset > 0) {
+        commit(buffer, stream.offset, level);
+    }
+}
+
+// Format into a stack buffer; kept out of line so callers using a staging
+// buffer do not reserve the stack space
+static __attribute__((noinline)) void log_print_local(int level, const char* fmt, log_args_t* args)
+{
+    char buffer[LOG_BUFFER_SIZE];
+
+    log_format_record(buffer, sizeof(buffer), level, fmt, args, log_output_internal);
+}
 
-    // Output the buffer
-    if (offset > 0) {
-        log_output_internal(buffer, offset);
+static void log_vprint_level(int level, const char* fmt, log_args_t* args)
+{
+#if LOG_STATS_MODE
+    uint32_t start = log_stats_print_start();
+#endif
+    size_t max;
+    char* buffer = log_staging_acquire(&max);
+
+    if (buffer != NULL) {
+        log_format_record(buffer, max, level, fmt, args, log_staging_commit);
+    } else {
+        log_print_local(level, fmt, args);
     }
-}
\ No newline at end of file
+
+#if LOG_STATS_MODE
+    log_stats_print_done(start);
+#endif
+}
+
+void log_print(const char* fmt, ...)
+{
+    log_args_t args = { .words = NULL };
+
+    va_start(args.ap, fmt);
+    log_vprint_level(LOG_LEVEL_OFF, fmt, &args);
+    va_end(args.ap);
+}
+
+void log_print_level(int level, const char* fmt, ...)
+{
+    log_args_t args = { .words = NULL };
+
+    va_start(args.ap, fmt);
+    log_vprint_level(level, fmt, &args);
+    va_end(args.ap);
+}
+
+void log_vprint(const char* fmt, va_list ap)
+{
+    log_args_t args = { .words = NULL };
+
+    va_copy(args.ap, ap);
+    log_vprint_level(LOG_LEVEL_OFF, fmt, &args);
+    va_end(args.ap);
+}
@@ -39,11 +39,46 @@ extern "C" {
 #define LOG_LEVEL_INFO  3 /** General informational messages about application state */
 #define LOG_LEVEL_DEBUG 4 /** Detailed debug messages for troubleshooting */
 
+/**
+ * \brief Machine word holding one pre-encoded log argument.
+ *
+ * Pointers and values up to the word size take one word; 64-bit values on
+ * 32-bit targets take two, low word first.
+ */
+typedef uintptr_t log_word_t;
+
 /**
  * \brief Function pointer type for custom output handlers.
  */
 typedef void (*log_output_handler_t)(const char* message, size_t length);
 
+/**
+ * \brief Function pointer type for sinks added with log_sink_add().
+ *
+ * \param ctx     Context pointer given to log_sink_add().
+ * \param message Record bytes, shared by every sink; do not modify.
+ * \param length  Number of bytes in message.
+ */
+typedef void (*log_sink_handler_t)(void* ctx, const char* message, size_t length);
+
+/**
+ * \brief Record attributes passed along with every formatted record.
+ *
+ * The low bits hold the LOG_LEVEL_* of the record. LOG_LEVEL_OFF marks
+ * output from LOG() and internal notes, which every enabled sink accepts.
+ */
+#define LOG_RECORD_LEVEL_MASK 0x07
+#define LOG_RECORD_BINARY     0x08 /** Deferred binary frame instead of text */
+#define LOG_RECORD_MORE       0x10 /** Leading chunk; the record continues in the next one */
+
+/**
+ * \brief Sink encodings, selecting which records a sink receives.
+ */
+#define LOG_SINK_TEXT   0x01 /** Formatted text records */
+#define LOG_SINK_BINARY 0x02 /** Deferred binary frames */
+
+#define LOG_SINK_CONSOLE 0 /** Sink of log_register_output_handler() / log_output_default() */
+
 /* Defines the maximum log level for compile-time logging. Only log messages
     at this level or higher severity will be compiled into the binary.
     Messages below the LOG_MAX_LEVEL will be completely excluded from the binary. */
@@ -56,39 +91,265 @@ typedef void (*log_output_handler_t)(const char* message, size_t length);
 #define LOG_VERBOSE_MODE 0 /* 0 = simple mode, 1 = verbose mode */
 #endif
 
+/* Define asynchronous mode - formatted records are queued in the lock-free
+    ring from log_ring.h and written to the output handler by log_ring_drain(),
+    so callers never wait on the UART */
+#ifndef LOG_ASYNC_MODE
+#define LOG_ASYNC_MODE 0 /* 0 = synchronous output, 1 = queued output */
+#endif
+
+/* Define deferred mode - the LOG_* macros send a string id plus raw argument
+    values instead of formatted text; see log_deferred.h. Not available in C++ */
+#ifndef LOG_DEFERRED_MODE
+#define LOG_DEFERRED_MODE 0 /* 0 = formatted text, 1 = deferred binary frames */
+#endif
+
+/* Define timestamp mode - every record carries a timestamp taken once from
+    log_timestamp_raw(). Text records print it in microseconds, deferred
+    frames carry the tick delta from the previous frame */
+#ifndef LOG_TIMESTAMP_MODE
+#define LOG_TIMESTAMP_MODE 0 /* 0 = no timestamps, 1 = timestamped records */
+#endif
+
+/* Rate of the log_timestamp_raw() counter. The default matches MTIME_FREQ_HZ
+    in examples/timer_baremetal/timer.h */
+#ifndef LOG_TIMESTAMP_HZ
+#define LOG_TIMESTAMP_HZ 25000000
+#endif
+
+/* LOG_TIMESTAMP_READ() may be defined to read the low 32 bits of the
+    log_timestamp_raw() counter inline, e.g. the mtime register. The rate
+    limit check uses it; without it, mcycle is read with csrr */
+
+#if LOG_TIMESTAMP_HZ <= 1000000
+#error "LOG_TIMESTAMP_HZ must be above 1 MHz"
+#endif
+
+#if LOG_DEFERRED_MODE && !defined(__cplusplus)
+#include "log_deferred.h"
+#endif
+
+/* Define duplicate suppression - a record identical to the previous one
+    (ignoring its timestamp) is dropped and counted, and the count is printed
+    as "last message repeated N times" before the next different record */
+#ifndef LOG_DEDUP_MODE
+#define LOG_DEDUP_MODE 0 /* 0 = off, 1 = collapse repeats */
+#endif
+
+/* Define crash log mode - every record is also copied into the reset
+    persistent ring from log_crash.h, and log_init() dumps the ring left by
+    the previous boot */
+#ifndef LOG_CRASH_MODE
+#define LOG_CRASH_MODE 0 /* 0 = off, 1 = keep a crash log in .noinit */
+#endif
+
+/* Define float mode - log_print() formats %f, %e and %g (and %F %E %G)
+    with precision, using the shortest round-trip digits from log_float.c,
+    which must then be linked. Off, the formatter carries no float code */
+#ifndef LOG_FLOAT_MODE
+#define LOG_FLOAT_MODE 0 /* 0 = no float conversions, 1 = %f %e %g */
+#endif
+
+/* Define statistics mode - log.c counts records, bytes, truncations and
+    drops, and times log_print() and uart_write() with mcycle from
+    riscv_csr.h, which must be on the include path; see log_stats_get() */
+#ifndef LOG_STATS_MODE
+#define LOG_STATS_MODE 0 /* 0 = off, 1 = keep counters */
+#endif
+
+/* Maximum number of sinks, including the console sink */
+#ifndef LOG_MAX_SINKS
+#define LOG_MAX_SINKS 4
+#endif
+
+/* Size of the buffer log_print() formats a record into when no staging
+    buffer is available. Longer records reach the sinks in chunks of this
+    size, so it trades task stack against the number of sink calls */
+#ifndef LOG_BUFFER_SIZE
+#define LOG_BUFFER_SIZE 128
+#endif
+
 #define LOG(...) log_print(__VA_ARGS__)
 
-#if LOG_VERBOSE_MODE
-#define LOG_FORMAT(level, fmt, ...) \
-    log_print("\n[%s] %s:%d:%s() - " fmt, level, __FILE_NAME__, __LINE__, __func__, ##__VA_ARGS__)
+/* Timestamp prefix of text records, in microseconds */
+#if LOG_TIMESTAMP_MODE
+#define LOG_TS_FMT "[%10llu] "
+#define LOG_TS_ARG (unsigned long long)log_timestamp_us(),
+#else
+#define LOG_TS_FMT ""
+#define LOG_TS_ARG
+#endif
+
+/* Output one record; level is the LOG_LEVEL_* value, tag its short name */
+#if LOG_DEFERRED_MODE && !defined(__cplusplus)
+#define LOG_FORMAT(level, tag, fmt, ...) LOG_DEFERRED(level, tag, fmt, ##__VA_ARGS__)
+#elif LOG_VERBOSE_MODE
+#define LOG_FORMAT(level, tag, fmt, ...) \
+    log_print_level(level, "\n" LOG_TS_FMT "[%s] %s:%d:%s() - " fmt, LOG_TS_ARG tag, __FILE_NAME__, __LINE__, __func__, ##__VA_ARGS__)
+#else
+#define LOG_FORMAT(level, tag, fmt, ...) log_print_level(level, "\n" LOG_TS_FMT "[%s] " fmt, LOG_TS_ARG tag, ##__VA_ARGS__)
+#endif
+
+/* Runtime level every module starts with; messages above it are compiled in
+    (up to LOG_MAX_LEVEL) but skipped until enabled with log_set_level() */
+#ifndef LOG_DEFAULT_LEVEL
+#define LOG_DEFAULT_LEVEL LOG_MAX_LEVEL
+#endif
+
+/* Modules with their own runtime level. Override the list to add modules */
+#ifndef LOG_MODULE_LIST
+#define LOG_MODULE_LIST(X) \
+    X(DEFAULT) \
+    X(APP) \
+    X(TIMER) \
+    X(UART) \
+    X(LOG)
+#endif
+
+#define LOG_MODULE_ENUM(name) LOG_MODULE_##name,
+enum {
+    LOG_MODULE_LIST(LOG_MODULE_ENUM)
+    LOG_MODULE_COUNT
+};
+#undef LOG_MODULE_ENUM
+
+#define LOG_MODULE_ALL (-1) /** Apply log_set_level() to every module */
+
+/* Module used by the LOG_* macros without a module tag. Define it before
+    including log.h to tag a whole file */
+#ifndef LOG_MODULE
+#define LOG_MODULE LOG_MODULE_DEFAULT
+#endif
+
+/**
+ * \brief Current runtime level of each module, indexed by LOG_MODULE_*.
+ *
+ * Read directly by the LOG_* macros; change it with log_set_level().
+ */
+extern uint8_t log_module_levels[LOG_MODULE_COUNT];
+
+/* One byte load and one branch; arguments are only evaluated when enabled */
+#define LOG_ENABLED(module, level) (log_module_levels[(module)] >= (level))
+
+#define LOG_FILTERED(module, level, tag, fmt, ...) do { \
+    if (LOG_ENABLED(module, level)) { \
+        LOG_FORMAT(level, tag, fmt, ##__VA_ARGS__); \
+    } \
+} while (0)
+
+#define LOG_RATELIMITED(module, level, tag, n_per_sec, fmt, ...) do { \
+    static log_ratelimit_t log_rl_; \
+    if (LOG_ENABLED(module, level) && log_ratelimit(&log_rl_, (n_per_sec))) { \
+        LOG_FORMAT(level, tag, fmt, ##__VA_ARGS__); \
+    } \
+} while (0)
+
+/* A countdown instead of a modulo keeps division off the rejected path */
+#define LOG_SAMPLED(module, level, tag, one_in_n, fmt, ...) do { \
+    static uint32_t log_left_ = 1; \
+    if (LOG_ENABLED(module, level) && --log_left_ == 0) { \
+        log_left_ = (one_in_n) ? (one_in_n) : 1; \
+        LOG_FORMAT(level, tag, fmt, ##__VA_ARGS__); \
+    } \
+} while (0)
+
+#if LOG_MAX_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR_M(module, _fmt, ...) LOG_FILTERED(module, LOG_LEVEL_ERROR, "ERR", _fmt, ##__VA_ARGS__)
 #else
-#define LOG_FORMAT(level, fmt, ...) log_print("\n[%s] " fmt, level, ##__VA_ARGS__)
+#define LOG_ERROR_M(...) ((void) 0)
 #endif
 
+#if LOG_MAX_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN_M(module, _fmt, ...) LOG_FILTERED(module, LOG_LEVEL_WARN, "WAR", _fmt, ##__VA_ARGS__)
+#else
+#define LOG_WARN_M(...) ((void) 0)
+#endif
+
+#if LOG_MAX_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO_M(module, _fmt, ...) LOG_FILTERED(module, LOG_LEVEL_INFO, "INF", _fmt, ##__VA_ARGS__)
+#else
+#define LOG_INFO_M(...) ((void) 0)
+#endif
+
+/**
+ * \brief Descriptor of one LOG_DEBUG call site.
+ *
+ * Every LOG_DEBUG statement places one of these in the .logsite section so
+ * individual sites can be listed and toggled at runtime, like Linux dynamic
+ * debug. enabled follows the module level until a site is toggled directly.
+ */
+typedef struct log_site {
+    const char* file;
+    const char* fmt;
+    uint16_t line;
+    uint8_t module;
+    uint8_t enabled;
+    uint32_t hits;         /** Times the site was reached while enabled */
+} log_site_t;
+
+/* A disabled site costs one byte load and one branch on its own flag */
+#define LOG_SITE(module, tag, _fmt, ...) do { \
+    static log_site_t log_site_ __attribute__((section(".logsite"), used, aligned(4))) = \
+        { __FILE_NAME__, _fmt, __LINE__, (module), LOG_DEFAULT_LEVEL >= LOG_LEVEL_DEBUG, 0 }; \
+    if (__builtin_expect(log_site_.enabled, 0)) { \
+        __atomic_fetch_add(&log_site_.hits, 1, __ATOMIC_RELAXED); \
+        LOG_FORMAT(LOG_LEVEL_DEBUG, tag, _fmt, ##__VA_ARGS__); \
+    } \
+} while (0)
+
+#if LOG_MAX_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG_M(module, _fmt, ...) LOG_SITE(module, "DBG", _fmt, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG_M(...) ((void) 0)
+#endif
+
+/* Rate limited (at most n records per second) and sampled (every nth
+    record) variants, with per call site state */
 #if LOG_MAX_LEVEL >= LOG_LEVEL_ERROR
-#define LOG_ERROR(_fmt, ...) LOG_FORMAT("ERR", _fmt, ##__VA_ARGS__)
+#define LOG_ERROR_RATELIMITED(n_per_sec, _fmt, ...) \
+    LOG_RATELIMITED(LOG_MODULE, LOG_LEVEL_ERROR, "ERR", n_per_sec, _fmt, ##__VA_ARGS__)
+#define LOG_ERROR_SAMPLED(one_in_n, _fmt, ...) \
+    LOG_SAMPLED(LOG_MODULE, LOG_LEVEL_ERROR, "ERR", one_in_n, _fmt, ##__VA_ARGS__)
 #else
-#define LOG_ERROR(...) ((void) 0)
+#define LOG_ERROR_RATELIMITED(...) ((void) 0)
+#define LOG_ERROR_SAMPLED(...) ((void) 0)
 #endif
 
 #if LOG_MAX_LEVEL >= LOG_LEVEL_WARN
-#define LOG_WARN(_fmt, ...) LOG_FORMAT("WAR", _fmt, ##__VA_ARGS__)
+#define LOG_WARN_RATELIMITED(n_per_sec, _fmt, ...) \
+    LOG_RATELIMITED(LOG_MODULE, LOG_LEVEL_WARN, "WAR", n_per_sec, _fmt, ##__VA_ARGS__)
+#define LOG_WARN_SAMPLED(one_in_n, _fmt, ...) \
+    LOG_SAMPLED(LOG_MODULE, LOG_LEVEL_WARN, "WAR", one_in_n, _fmt, ##__VA_ARGS__)
 #else
-#define LOG_WARN(...) ((void) 0)
+#define LOG_WARN_RATELIMITED(...) ((void) 0)
+#define LOG_WARN_SAMPLED(...) ((void) 0)
 #endif
 
 #if LOG_MAX_LEVEL >= LOG_LEVEL_INFO
-#define LOG_INFO(_fmt, ...) LOG_FORMAT("INF", _fmt, ##__VA_ARGS__)
+#define LOG_INFO_RATELIMITED(n_per_sec, _fmt, ...) \
+    LOG_RATELIMITED(LOG_MODULE, LOG_LEVEL_INFO, "INF", n_per_sec, _fmt, ##__VA_ARGS__)
+#define LOG_INFO_SAMPLED(one_in_n, _fmt, ...) \
+    LOG_SAMPLED(LOG_MODULE, LOG_LEVEL_INFO, "INF", one_in_n, _fmt, ##__VA_ARGS__)
 #else
-#define LOG_INFO(...) ((void) 0)
+#define LOG_INFO_RATELIMITED(...) ((void) 0)
+#define LOG_INFO_SAMPLED(...) ((void) 0)
 #endif
 
 #if LOG_MAX_LEVEL >= LOG_LEVEL_DEBUG
-#define LOG_DEBUG(_fmt, ...) LOG_FORMAT("DBG", _fmt, ##__VA_ARGS__)
+#define LOG_DEBUG_RATELIMITED(n_per_sec, _fmt, ...) \
+    LOG_RATELIMITED(LOG_MODULE, LOG_LEVEL_DEBUG, "DBG", n_per_sec, _fmt, ##__VA_ARGS__)
+#define LOG_DEBUG_SAMPLED(one_in_n, _fmt, ...) \
+    LOG_SAMPLED(LOG_MODULE, LOG_LEVEL_DEBUG, "DBG", one_in_n, _fmt, ##__VA_ARGS__)
 #else
-#define LOG_DEBUG(...) ((void) 0)
+#define LOG_DEBUG_RATELIMITED(...) ((void) 0)
+#define LOG_DEBUG_SAMPLED(...) ((void) 0)
 #endif
 
+#define LOG_ERROR(_fmt, ...) LOG_ERROR_M(LOG_MODULE, _fmt, ##__VA_ARGS__)
+#define LOG_WARN(_fmt, ...)  LOG_WARN_M(LOG_MODULE, _fmt, ##__VA_ARGS__)
+#define LOG_INFO(_fmt, ...)  LOG_INFO_M(LOG_MODULE, _fmt, ##__VA_ARGS__)
+#define LOG_DEBUG(_fmt, ...) LOG_DEBUG_M(LOG_MODULE, _fmt, ##__VA_ARGS__)
+
 /**
  * \brief Initialize the logging system.
  *
@@ -97,21 +358,376 @@ typedef void (*log_output_handler_t)(const char* message, size_t length);
  */
 void log_init(void);
 
+/**
+ * \brief Change the runtime level of a module.
+ *
+ * Takes effect immediately, from any context. Levels above LOG_MAX_LEVEL
+ * have no effect because those messages are not compiled in.
+ *
+ * \param module LOG_MODULE_* index, or LOG_MODULE_ALL.
+ * \param level  LOG_LEVEL_* value.
+ */
+void log_set_level(int module, int level);
+
+/**
+ * \brief Change the runtime level of a module given its name.
+ *
+ * \param name  Module name as in LOG_MODULE_LIST, e.g. "TIMER".
+ * \param level LOG_LEVEL_* value.
+ * \return 0 on success, -1 if no module has that name.
+ */
+int log_set_level_by_name(const char* name, int level);
+
+/**
+ * \brief Get the runtime level of a module.
+ */
+int log_get_level(int module);
+
+/**
+ * \brief Get the name of a module, or NULL for an invalid index.
+ */
+const char* log_module_name(int module);
+
+/**
+ * \brief Output the pending "last message repeated" note now.
+ *
+ * Normally the note is printed before the next different record.
+ */
+void log_dedup_flush(void);
+
+/**
+ * \brief Report records rejected by a LOG_*_RATELIMITED call site.
+ */
+void log_suppressed(uint32_t count);
+
+/**
+ * \brief Logging overhead counters, see LOG_STATS_MODE.
+ *
+ * A record split into chunks counts once; binary frames and internal notes
+ * count like text records.
+ */
+typedef struct {
+    uint32_t records;          /** Records written to the sinks or queued */
+    uint32_t bytes;            /** Bytes of those records */
+    uint32_t truncated;        /** Records cut short to fit a fixed buffer */
+    uint32_t dropped;          /** Records the ring refused; see log_ring_dropped_records() for evictions */
+    uint32_t prints;           /** log_print() calls, including filtered-in LOG_* macros */
+    uint32_t print_max_cycles; /** Longest single log_print() call */
+    uint64_t print_cycles;     /** Total cycles spent in log_print() */
+    uint32_t uart_max_cycles;  /** Longest single uart_write() of a record, mostly waiting on the FIFO */
+} log_stats_t;
+
+/**
+ * \brief Read a snapshot of the counters; all zero without LOG_STATS_MODE.
+ */
+void log_stats_get(log_stats_t* stats);
+
+/**
+ * \brief Clear the counters, e.g. at the start of a measurement window.
+ */
+void log_stats_reset(void);
+
+/**
+ * \brief Print the counters through the logger.
+ */
+void log_stats_dump(void);
+
+/**
+ * \brief Count a record truncated outside of log.c, e.g. a deferred frame.
+ */
+void log_stats_truncated(void);
+
+/**
+ * \brief Start timing a print; used by front ends other than log_print().
+ *
+ * \return Start value for log_stats_print_done(); 0 without LOG_STATS_MODE.
+ */
+uint32_t log_stats_print_start(void);
+
+/**
+ * \brief Count a print started with log_stats_print_start() and its cycles.
+ */
+void log_stats_print_done(uint32_t start);
+
+/**
+ * \brief Read the timestamp counter.
+ *
+ * Weak; the default reads mcycle. Override it to use another counter such
+ * as mtimer_get_raw_time(), and set LOG_TIMESTAMP_HZ to its rate.
+ *
+ * \return Counter value in LOG_TIMESTAMP_HZ ticks.
+ */
+uint64_t log_timestamp_raw(void);
+
+/**
+ * \brief Current timestamp in microseconds.
+ *
+ * Converts log_timestamp_raw() with a fixed-point multiply; no division.
+ */
+uint64_t log_timestamp_us(void);
+
+/**
+ * \brief Enable or disable LOG_DEBUG call sites.
+ *
+ * \param file   File name as printed by __FILE_NAME__, or NULL for any file.
+ * \param line   Line number, or 0 for every line in file.
+ * \param enable Non-zero to enable the matching sites.
+ * \return Number of sites that matched.
+ */
+int log_site_enable(const char* file, int line, int enable);
+
+/**
+ * \brief Number of LOG_DEBUG call sites linked into the image.
+ */
+int log_site_count(void);
+
+/**
+ * \brief Get a call site descriptor by index, or NULL past the end.
+ */
+log_site_t* log_site_get(int index);
+
+/**
+ * \brief Print every call site with its state and hit count.
+ */
+void log_site_dump(void);
+
 /**
  * \brief Register a custom output handler.
  *
+ * Replaces the UART output of the console sink; other sinks are unaffected.
+ *
  * \param handler Function pointer to custom output handler
  */
 void log_register_output_handler(log_output_handler_t handler);
 
+/**
+ * \brief Attach an output sink.
+ *
+ * Every record is formatted once and the same bytes are handed to each sink
+ * whose level and encoding accept it, in the context that outputs records:
+ * the caller in synchronous mode, the drain in LOG_ASYNC_MODE.
+ *
+ * \param handler  Sink function.
+ * \param ctx      Passed to handler.
+ * \param level    Highest LOG_LEVEL_* the sink receives.
+ * \param encoding LOG_SINK_TEXT and/or LOG_SINK_BINARY.
+ * \return Sink index, or -1 if all LOG_MAX_SINKS slots are in use.
+ */
+int log_sink_add(log_sink_handler_t handler, void* ctx, int level, int encoding);
+
+/**
+ * \brief Detach a sink added with log_sink_add().
+ */
+void log_sink_remove(int sink);
+
+/**
+ * \brief Change the highest level a sink receives.
+ *
+ * \param sink  Sink index, or LOG_SINK_CONSOLE.
+ * \param level LOG_LEVEL_* value; LOG_LEVEL_OFF mutes the sink.
+ */
+void log_sink_set_level(int sink, int level);
+
+/**
+ * \brief Write a record straight to the sinks.
+ *
+ * Bypasses the asynchronous ring. Used by the ring drain and for output
+ * that must not be deferred.
+ *
+ * \param message Record bytes.
+ * \param length  Number of bytes in message.
+ * \param attr    Record level, or'ed with LOG_RECORD_BINARY for frames.
+ */
+void log_output_direct(const char* message, size_t length, int attr);
+
+/**
+ * \brief Output a finished record.
+ *
+ * Takes the same path as log_print() output: queued in the asynchronous
+ * ring when LOG_ASYNC_MODE is enabled, written directly otherwise.
+ *
+ * \param message Record bytes.
+ * \param length  Number of bytes in message.
+ * \param attr    Record level, or'ed with LOG_RECORD_BINARY for frames.
+ */
+void log_output_record(const char* message, size_t length, int attr);
+
+/**
+ * \brief Get a staging buffer for the calling context.
+ *
+ * log_print() formats into the returned buffer instead of its own stack
+ * buffer. The default implementation returns NULL; an RTOS port overrides
+ * it to hand out a per-task buffer.
+ *
+ * \param size Set to the size of the returned buffer.
+ * \return Buffer, or NULL to format on the stack.
+ */
+char* log_staging_acquire(size_t* size);
+
+/**
+ * \brief Commit a record formatted into a staging buffer.
+ *
+ * The default implementation calls log_output_record(). An RTOS port
+ * overrides it to make the write atomic with respect to other tasks.
+ * A record longer than the buffer is committed in several chunks; all but
+ * the last carry LOG_RECORD_MORE.
+ *
+ * \param record Record bytes, in the buffer from log_staging_acquire().
+ * \param length Number of bytes in record.
+ * \param attr   Record attributes for log_output_record().
+ */
+void log_staging_commit(const char* record, size_t length, int attr);
+
 /**
  * \brief Print a formatted string.
  *
+ * Records longer than the format buffer are not truncated but written in
+ * chunks. In LOG_ASYNC_MODE each chunk is queued on its own, so chunks of
+ * records from different contexts may interleave.
+ *
  * \param fmt Format string.
  * \param ... Format arguments.
  */
 void log_print(const char* fmt, ...);
 
+/**
+ * \brief Print a formatted record at a log level.
+ *
+ * Used by the LOG_* macros; the level selects the sinks that receive it.
+ *
+ * \param level LOG_LEVEL_* of the record.
+ * \param fmt   Format string.
+ * \param ...   Format arguments.
+ */
+void log_print_level(int level, const char* fmt, ...);
+
+/**
+ * \brief Print a formatted string from a variable argument list.
+ *
+ * Same as log_print(), for wrappers that take their own "...".
+ *
+ * \param fmt Format string.
+ * \param ap  Format arguments.
+ */
+void log_vprint(const char* fmt, va_list ap);
+
+/**
+ * \brief Format into a caller buffer, like vsnprintf().
+ *
+ * Uses the log_print() conversions and never touches the sinks, so packet
+ * or frame builders can format in place without pulling in stdio. The
+ * output is truncated to the buffer.
+ *
+ * \param buffer Destination buffer, always NUL terminated unless max is 0.
+ * \param max    Size of buffer.
+ * \param fmt    Format string.
+ * \param ap     Format arguments.
+ * \return Length of the output excluding the terminator.
+ */
+size_t log_vformat(char* buffer, size_t max, const char* fmt, va_list ap);
+
+/**
+ * \brief Format a record from pre-encoded argument words.
+ *
+ * Same conversions as log_print(), with arguments taken from words instead
+ * of a variable argument list.
+ *
+ * \param buffer Destination buffer, always NUL terminated.
+ * \param max    Size of buffer.
+ * \param fmt    Format string.
+ * \param words  Arguments, encoded as described for log_word_t.
+ * \return Length of the record excluding the terminator.
+ */
+size_t log_format_words(char* buffer, size_t max, const char* fmt, const log_word_t* words);
+
+/**
+ * \brief Append a string to a record buffer.
+ *
+ * Formatting primitive shared by log_print() and the C++ front end in log.hpp.
+ *
+ * \param buffer    Record buffer.
+ * \param offset    Write position, advanced past the appended text.
+ * \param max       Size of buffer; one byte is kept for the terminator.
+ * \param str       String to append.
+ * \param precision Maximum number of characters, or -1 for no limit.
+ * \return Number of characters appended.
+ */
+int log_append_str(char* buffer, size_t* offset, size_t max, const char* str, int precision);
+
+/**
+ * \brief Append a number to a record buffer.
+ *
+ * Formatting primitive shared by log_print() and the C++ front end in log.hpp.
+ *
+ * \param buffer    Record buffer.
+ * \param offset    Write position, advanced past the appended text.
+ * \param max       Size of buffer; one byte is kept for the terminator.
+ * \param num       Value to append.
+ * \param base      10 or 16.
+ * \param is_signed Treat num as a signed 64-bit value.
+ * \param width     Minimum field width, including the sign.
+ * \param zero_pad  Pad to width with '0' instead of ' '.
+ * \param upper     Use upper case hex digits.
+ * \return Number of characters appended.
+ */
+int log_append_num(char* buffer, size_t* offset, size_t max, uint64_t num, int base, int is_signed, int width, int zero_pad, int upper);
+
+/* Largest number log_append_num() writes without padding: sign and 20 digits */
+#define LOG_NUM_MAX 24
+
+/**
+ * \brief Per call site state of the LOG_*_RATELIMITED macros.
+ */
+typedef struct log_ratelimit {
+    uint32_t start;        /** log_timestamp_low() at window start */
+    uint32_t count;        /** Records let through in this window */
+    uint32_t suppressed;   /** Records rejected in this window */
+} log_ratelimit_t;
+
+/**
+ * \brief Low 32 bits of the timestamp counter, read without a call.
+ */
+static inline uint32_t log_timestamp_low(void)
+{
+#if defined(LOG_TIMESTAMP_READ)
+    return (uint32_t)LOG_TIMESTAMP_READ();
+#elif defined(__riscv)
+    unsigned long cycles;
+    __asm__ volatile ("csrr %0, mcycle" : "=r"(cycles));
+    return (uint32_t)cycles;
+#else
+    return (uint32_t)log_timestamp_raw();
+#endif
+}
+
+/**
+ * \brief Let at most burst records through per second.
+ *
+ * The window is compared on the low 32 bits of the timestamp counter, so a
+ * site idle for over 2^32 ticks may wait up to one extra window.
+ *
+ * \return Non-zero if the record may be output.
+ */
+static inline int log_ratelimit(log_ratelimit_t* rl, uint32_t burst)
+{
+    uint32_t now = log_timestamp_low();
+
+    if (now - rl->start >= LOG_TIMESTAMP_HZ) {
+        if (rl->suppressed) {
+            log_suppressed(rl->suppressed);
+        }
+        rl->start = now;
+        rl->count = 0;
+        rl->suppressed = 0;
+    }
+    if (rl->count < burst) {
+        rl->count++;
+        return 1;
+    }
+    rl->suppressed++;
+    return 0;
+}
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
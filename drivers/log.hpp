@@ -0,0 +1,431 @@
+/*
+ * -----------------------------------------------------
+ *      __  __  _____  _____    _____
+ *     |  \/  ||_   _||  __ \  / ____|
+ *     | \  / |  | |  | |__) || (___
+ *     | |\/| |  | |  |  ___/  \___ \
+ *     | |  | | _| |_ | |      ____) |
+ *     |_|  |_||_____||_|     |_____/
+ * -----------------------------------------------------
+ * Copyright (c) 2025, MIPS All rights reserved.
+ * -----------------------------------------------------
+ */
+
+/**
+ * \file log.hpp
+ * \brief C++17 logging front end with compile-time parsed format strings.
+ *
+ * Including this header instead of log.h makes the LOG_* macros parse their
+ * format string at compile time. Each call site expands to a fixed sequence
+ * of log_append_str()/log_append_num() calls, and arguments that do not
+ * match their conversion are rejected by static_assert. As with log_print(),
+ * records go through the task's staging buffer when there is one and are
+ * written in chunks when longer than the buffer, never truncated.
+ *
+ * Supported conversions are the ones log_print() understands:
+ * %s %d %i %u %x %X %p %c %%, with '0' flag, width, precision and the
+ * h, hh, l, ll, z, j and t length modifiers.
+ */
+
+#ifndef LOG_HPP
+#define LOG_HPP
+
+#include <cstdint>
+#include <type_traits>
+#include "log.h"
+
+/* Size of the stack buffer a call site formats into when no staging buffer
+    is available; longer records reach the sinks in chunks of this size */
+#ifndef LOG_CXX_BUFFER_SIZE
+#define LOG_CXX_BUFFER_SIZE LOG_BUFFER_SIZE
+#endif
+
+namespace log_cxx {
+
+enum class Conv : char {
+    End,      /* Trailing literal text, no conversion */
+    Percent,  /* %% */
+    Str,      /* %s */
+    Signed,   /* %d %i */
+    Unsigned, /* %u */
+    Hex,      /* %x */
+    HexUpper, /* %X */
+    Ptr,      /* %p */
+    Char,     /* %c */
+    Invalid,
+};
+
+/* One piece of a format string: literal text followed by a conversion */
+struct Piece {
+    size_t lit_begin;
+    size_t lit_len;
+    Conv conv;
+    unsigned char arg_size; /* sizeof the type selected by the length modifier */
+    unsigned char cut_size; /* h and hh: the value is cut to short or char, like printf() */
+    bool zero_pad;
+    int width;
+    int precision;
+};
+
+template <size_t N>
+struct Pieces {
+    Piece piece[N];
+};
+
+constexpr bool is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+/* Parse the conversion at fmt[pos] (just past '%'); returns the next position */
+constexpr size_t parse_spec(const char* fmt, size_t pos, Piece& p)
+{
+    p.zero_pad = false;
+    p.width = 0;
+    p.precision = -1;
+    p.arg_size = sizeof(int);
+    p.cut_size = 0;
+
+    if (fmt[pos] == '0') {
+        p.zero_pad = true;
+        pos++;
+    }
+    while (is_digit(fmt[pos])) {
+        p.width = p.width * 10 + (fmt[pos++] - '0');
+    }
+    if (fmt[pos] == '.') {
+        pos++;
+        p.precision = 0;
+        while (is_digit(fmt[pos])) {
+            p.precision = p.precision * 10 + (fmt[pos++] - '0');
+        }
+    }
+    switch (fmt[pos]) {
+        case 'h':
+            if (fmt[pos + 1] == 'h') {
+                p.cut_size = sizeof(char);
+                pos++;
+            } else {
+                p.cut_size = sizeof(short);
+            }
+            pos++;
+            break;
+        case 'l':
+            if (fmt[pos + 1] == 'l') {
+                p.arg_size = sizeof(long long);
+                pos++;
+            } else {
+                p.arg_size = sizeof(long);
+            }
+            pos++;
+            break;
+        case 'z': p.arg_size = sizeof(size_t); pos++; break;
+        case 'j': p.arg_size = sizeof(intmax_t); pos++; break;
+        case 't': p.arg_size = sizeof(ptrdiff_t); pos++; break;
+        default: break;
+    }
+
+    switch (fmt[pos]) {
+        case 's': p.conv = Conv::Str; break;
+        case 'd':
+        case 'i': p.conv = Conv::Signed; break;
+        case 'u': p.conv = Conv::Unsigned; break;
+        case 'x': p.conv = Conv::Hex; break;
+        case 'X': p.conv = Conv::HexUpper; break;
+        case 'p': p.conv = Conv::Ptr; break;
+        case 'c': p.conv = Conv::Char; break;
+        case '%': p.conv = Conv::Percent; break;
+        default:  p.conv = Conv::Invalid; return pos;
+    }
+    return pos + 1;
+}
+
+constexpr size_t count_pieces(const char* fmt)
+{
+    size_t count = 1;
+    for (size_t pos = 0; fmt[pos]; ) {
+        if (fmt[pos] != '%') {
+            pos++;
+            continue;
+        }
+        Piece p{};
+        pos = parse_spec(fmt, pos + 1, p);
+        count++;
+        if (p.conv == Conv::Invalid) {
+            break;
+        }
+    }
+    return count;
+}
+
+template <size_t N>
+constexpr Pieces<N> parse(const char* fmt)
+{
+    Pieces<N> out{};
+    size_t pos = 0;
+    size_t lit_begin = 0;
+
+    for (size_t i = 0; i < N - 1; i++) {
+        while (fmt[pos] != '%') {
+            pos++;
+        }
+        Piece& p = out.piece[i];
+        p.lit_begin = lit_begin;
+        p.lit_len = pos - lit_begin;
+        pos = parse_spec(fmt, pos + 1, p);
+        lit_begin = pos;
+    }
+
+    /* Trailing literal; emit() rejects the format if a conversion was invalid */
+    Piece& last = out.piece[N - 1];
+    while (fmt[pos]) {
+        pos++;
+    }
+    last.lit_begin = lit_begin;
+    last.lit_len = pos - lit_begin;
+    last.conv = Conv::End;
+    return out;
+}
+
+template <class Fmt>
+struct Parsed {
+    static constexpr size_t count = count_pieces(Fmt::str());
+    static constexpr Pieces<count> value = parse<count>(Fmt::str());
+};
+
+template <class T>
+struct dependent_false : std::false_type {};
+
+template <class T>
+constexpr bool is_integer_v = (std::is_integral_v<T> && !std::is_same_v<T, bool>) || std::is_enum_v<T>;
+
+template <class T>
+constexpr auto as_integer(T v)
+{
+    if constexpr (std::is_enum_v<T>) {
+        return static_cast<std::underlying_type_t<T>>(v);
+    } else {
+        return v;
+    }
+}
+
+/*
+ * Output buffer of a record, as log_stream_t in log.c: when the buffer fills
+ * up, the text so far is committed as a chunk flagged LOG_RECORD_MORE and
+ * the buffer is reused.
+ */
+struct Stream {
+    char* buffer;
+    size_t max;
+    size_t offset;
+    int attr;
+    void (*commit)(const char* record, size_t length, int attr);
+
+    void flush()
+    {
+        if (offset > 0) {
+            commit(buffer, offset, attr | LOG_RECORD_MORE);
+            offset = 0;
+        }
+    }
+
+    void putc(char c)
+    {
+        if (offset >= max - 1) {
+            flush();
+        }
+        buffer[offset++] = c;
+    }
+
+    void puts(const char* str, int precision)
+    {
+        for (;;) {
+            int appended = log_append_str(buffer, &offset, max, str, precision);
+            str += appended;
+            if (precision >= 0) {
+                precision -= appended;
+            }
+            if (*str == '\0' || precision == 0) {
+                break;
+            }
+            flush();
+        }
+    }
+
+    void num(uint64_t value, int base, int is_signed, int width, int zero_pad, int upper)
+    {
+        size_t need = (width > LOG_NUM_MAX) ? (size_t)width : LOG_NUM_MAX;
+
+        if (need > max - 1 - offset) {
+            flush();
+            if (need > max - 1) {
+                /* Padding wider than the whole buffer: pad one character at a time */
+                char temp[LOG_NUM_MAX + 1];
+                size_t digits = 0;
+                int pad = width - log_append_num(temp, &digits, sizeof(temp), value, base, is_signed, 0, 0, upper);
+                const char* text = temp;
+
+                if (zero_pad && temp[0] == '-') {
+                    putc(*text++);
+                }
+                while (pad-- > 0) {
+                    putc(zero_pad ? '0' : ' ');
+                }
+                while (text < temp + digits) {
+                    putc(*text++);
+                }
+                return;
+            }
+        }
+        log_append_num(buffer, &offset, max, value, base, is_signed, width, zero_pad, upper);
+    }
+};
+
+template <class Fmt, size_t I, class T>
+inline void append_arg(Stream& stream, const T& arg)
+{
+    constexpr const Piece& P = Parsed<Fmt>::value.piece[I];
+    using D = std::decay_t<T>;
+
+    if constexpr (P.conv == Conv::Str) {
+        static_assert(std::is_convertible_v<D, const char*>, "%s expects a string");
+        const char* str = arg;
+        stream.puts(str ? str : "(null)", P.precision);
+    } else if constexpr (P.conv == Conv::Ptr) {
+        static_assert(std::is_pointer_v<D> || std::is_null_pointer_v<D>, "%p expects a pointer");
+        stream.puts("0x", -1);
+        stream.num((uintptr_t)(const void*)arg, 16, 0, P.width, 1, 0);
+    } else if constexpr (P.conv == Conv::Char) {
+        static_assert(is_integer_v<D>, "%c expects a character");
+        stream.putc((char)arg);
+    } else {
+        static_assert(is_integer_v<D>, "integer conversion expects an integer");
+        static_assert(sizeof(D) <= P.arg_size, "argument is wider than the conversion; add a length modifier");
+        auto value = as_integer(arg);
+        using V = decltype(value);
+        if constexpr (P.conv == Conv::Signed) {
+            int64_t num = (std::make_signed_t<V>)value;
+            if constexpr (P.cut_size == sizeof(char)) {
+                num = (signed char)value;
+            } else if constexpr (P.cut_size == sizeof(short)) {
+                num = (short)value;
+            }
+            stream.num((uint64_t)num, 10, 1, P.width, P.zero_pad, 0);
+        } else {
+            constexpr int base = (P.conv == Conv::Unsigned) ? 10 : 16;
+            uint64_t num = (std::make_unsigned_t<V>)value;
+            if constexpr (P.cut_size == sizeof(char)) {
+                num = (unsigned char)value;
+            } else if constexpr (P.cut_size == sizeof(short)) {
+                num = (unsigned short)value;
+            }
+            stream.num(num, base, 0, P.width, P.zero_pad, P.conv == Conv::HexUpper);
+        }
+    }
+}
+
+template <class Fmt, size_t I, class... Args>
+inline void emit(Stream& stream, const Args&... args);
+
+template <class Fmt, size_t I, class T, class... Rest>
+inline void emit_conv(Stream& stream, const T& arg, const Rest&... rest)
+{
+    append_arg<Fmt, I>(stream, arg);
+    emit<Fmt, I + 1>(stream, rest...);
+}
+
+template <class Fmt, size_t I, class... Args>
+inline void emit(Stream& stream, const Args&... args)
+{
+    constexpr const Piece& p = Parsed<Fmt>::value.piece[I];
+
+    if constexpr (p.lit_len > 0) {
+        stream.puts(Fmt::str() + p.lit_begin, p.lit_len);
+    }
+
+    if constexpr (p.conv == Conv::End) {
+        static_assert(sizeof...(Args) == 0, "too many arguments for format string");
+    } else if constexpr (p.conv == Conv::Invalid) {
+        static_assert(dependent_false<Fmt>::value, "unsupported conversion in format string");
+    } else if constexpr (p.conv == Conv::Percent) {
+        stream.putc('%');
+        emit<Fmt, I + 1>(stream, args...);
+    } else if constexpr (sizeof...(Args) == 0) {
+        static_assert(dependent_false<Fmt>::value, "too few arguments for format string");
+    } else {
+        emit_conv<Fmt, I>(stream, args...);
+    }
+}
+
+/* Format the record and commit what is left after the last chunk */
+template <class Fmt, class... Args>
+inline void format(Stream& stream, const Args&... args)
+{
+    emit<Fmt, 0>(stream, args...);
+    if (stream.offset > 0) {
+        stream.commit(stream.buffer, stream.offset, stream.attr);
+    }
+}
+
+/* Format into a stack buffer; kept out of line so call sites using a
+    staging buffer do not reserve the stack space */
+template <class Fmt, class... Args>
+__attribute__((noinline)) void print_local(int level, const Args&... args)
+{
+    char local[LOG_CXX_BUFFER_SIZE];
+    Stream stream = { local, sizeof(local), 0, level, log_output_record };
+
+    format<Fmt>(stream, args...);
+}
+
+/**
+ * \brief Format and output one record.
+ *
+ * Formats into the buffer from log_staging_acquire(), or else into a
+ * LOG_CXX_BUFFER_SIZE stack buffer, and commits it as log_print() does.
+ * Counts towards the LOG_STATS_MODE print statistics like log_print().
+ *
+ * \tparam Fmt   Type whose static constexpr str() returns the format string.
+ * \param  level LOG_LEVEL_* of the record, for the sinks.
+ */
+template <class Fmt, class... Args>
+inline void print(int level, const Args&... args)
+{
+#if LOG_STATS_MODE
+    uint32_t start = log_stats_print_start();
+#endif
+    Stream stream = { nullptr, 0, 0, level, log_staging_commit };
+
+    stream.buffer = log_staging_acquire(&stream.max);
+    if (stream.buffer != nullptr) {
+        format<Fmt>(stream, args...);
+    } else {
+        print_local<Fmt>(level, args...);
+    }
+#if LOG_STATS_MODE
+    log_stats_print_done(start);
+#endif
+}
+
+} // namespace log_cxx
+
+/* Format with a compile-time parsed format string; fmt must be a literal */
+#define LOG_CXX_LEVEL(level, fmt, ...) do { \
+    struct log_fmt_ { static constexpr const char* str() { return fmt; } }; \
+    ::log_cxx::print<log_fmt_>(level, ##__VA_ARGS__); \
+} while (0)
+
+#define LOG_CXX(fmt, ...) LOG_CXX_LEVEL(LOG_LEVEL_OFF, fmt, ##__VA_ARGS__)
+
+#undef LOG_FORMAT
+#if LOG_VERBOSE_MODE
+#define LOG_FORMAT(level, tag, fmt, ...) \
+    LOG_CXX_LEVEL(level, "\n" LOG_TS_FMT "[" tag "] %s:%d:%s() - " fmt, LOG_TS_ARG __FILE_NAME__, __LINE__, __func__, ##__VA_ARGS__)
+#elif LOG_TIMESTAMP_MODE
+#define LOG_FORMAT(level, tag, fmt, ...) \
+    LOG_CXX_LEVEL(level, "\n" LOG_TS_FMT "[" tag "] " fmt, (unsigned long long)log_timestamp_us(), ##__VA_ARGS__)
+#else
+#define LOG_FORMAT(level, tag, fmt, ...) LOG_CXX_LEVEL(level, "\n[" tag "] " fmt, ##__VA_ARGS__)
+#endif
+
+#endif /* LOG_HPP */
@@ -0,0 +1,238 @@
+/*
+ * -----------------------------------------------------
+ *      __  __  _____  _____    _____
+ *     |  \/  ||_   _||  __ \  / ____|
+ *     | \  / |  | |  | |__) || (___
+ *     | |\/| |  | |  |  ___/  \___ \
+ *     | |  | | _| |_ | |      ____) |
+ *     |_|  |_||_____||_|     |_____/
+ * -----------------------------------------------------
+ * Copyright (c) 2025, MIPS All rights reserved.
+ * -----------------------------------------------------
+ */
+
+#include <string.h>
+#include "log.h"
+#include "log_crash.h"
+
+#define LOG_CRASH_MASK (LOG_CRASH_SIZE - 1)
+
+/*
+ * Each record is framed by a four-byte header: a sync byte, a CRC-8 over
+ * the rest of the record, and the payload length in little-endian order.
+ * The oldest record in a full ring is partly overwritten and the newest may
+ * be torn by the reset, so the dump scans for a sync byte whose length and
+ * CRC check out and skips whatever does not.
+ */
+#define LOG_CRASH_SYNC 0xA5
+#define LOG_CRASH_HDR 4
+#define LOG_CRASH_MAX_RECORD (LOG_CRASH_SIZE - LOG_CRASH_HDR)
+
+/*
+ * The header fields that only change once per boot are covered by a CRC,
+ * so a header is trusted only if magic, size and CRC all match. The write
+ * position is a free-running byte counter outside the CRC: any value is a
+ * valid position, and leaving it out keeps a write down to one atomic add
+ * and the copy. The records carry their own CRC.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t size;
+    uint32_t boot;
+    uint32_t crc;
+    uint32_t head;
+    char data[LOG_CRASH_SIZE];
+} log_crash_ring_t;
+
+static log_crash_ring_t crash __attribute__((section(".noinit"), aligned(8)));
+
+/* CRC-8 (polynomial 0x07) lookup table, filled by log_crash_init() */
+static uint8_t crc8_table[256];
+
+// Bitwise CRC-32 (IEEE); only run at boot, so no table
+static uint32_t crc32(const void* data, size_t length)
+{
+    const uint8_t* p = data;
+    uint32_t crc = 0xFFFFFFFFu;
+
+    while (length--) {
+        crc ^= *p++;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+static uint32_t header_crc(void)
+{
+    return crc32(&crash, offsetof(log_crash_ring_t, crc));
+}
+
+static void crc8_init(void)
+{
+    for (int i = 0; i < 256; i++) {
+        uint8_t crc = i;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc << 1) ^ ((crc & 0x80) ? 0x07 : 0);
+        }
+        crc8_table[i] = crc;
+    }
+}
+
+static uint8_t crc8(uint8_t crc, const char* data, size_t length)
+{
+    while (length--) {
+        crc = crc8_table[crc ^ (uint8_t)*data++];
+    }
+    return crc;
+}
+
+static inline uint8_t crash_byte(uint32_t pos)
+{
+    return crash.data[pos & LOG_CRASH_MASK];
+}
+
+// Copy length bytes into the ring starting at pos, wrapping at the end
+static void crash_copy_in(uint32_t pos, const char* src, size_t length)
+{
+    uint32_t start = pos & LOG_CRASH_MASK;
+    size_t first = LOG_CRASH_SIZE - start;
+
+    if (first > length) {
+        first = length;
+    }
+    memcpy(&crash.data[start], src, first);
+    memcpy(&crash.data[0], src + first, length - first);
+}
+
+// Copy length bytes out of the ring starting at pos, wrapping at the end
+static void crash_copy_out(char* dst, uint32_t pos, size_t length)
+{
+    uint32_t start = pos & LOG_CRASH_MASK;
+    size_t first = LOG_CRASH_SIZE - start;
+
+    if (first > length) {
+        first = length;
+    }
+    memcpy(dst, &crash.data[start], first);
+    memcpy(dst + first, &crash.data[0], length - first);
+}
+
+// Find the first intact record at or after *pos that ends by head. Sets
+// *pos to its header and returns its payload length, or -1 if none is left.
+static int crash_next(uint32_t* pos, uint32_t head)
+{
+    for (; head - *pos >= LOG_CRASH_HDR; (*pos)++) {
+        if (crash_byte(*pos) != LOG_CRASH_SYNC) {
+            continue;
+        }
+        uint32_t length = crash_byte(*pos + 2) | ((uint32_t)crash_byte(*pos + 3) << 8);
+        if (length > head - *pos - LOG_CRASH_HDR) {
+            continue;
+        }
+        uint8_t crc = 0;
+        for (uint32_t i = 2; i < LOG_CRASH_HDR + length; i++) {
+            crc = crc8_table[crc ^ crash_byte(*pos + i)];
+        }
+        if (crc == crash_byte(*pos + 1)) {
+            return (int)length;
+        }
+    }
+    return -1;
+}
+
+// Position of the oldest byte still in the ring
+static uint32_t crash_tail(uint32_t head)
+{
+    return head - (head < LOG_CRASH_SIZE ? head : LOG_CRASH_SIZE);
+}
+
+void log_crash_init(void)
+{
+    static const char banner[] = "\n--- log before reset ---";
+    static const char footer[] = "\n--- end of log before reset ---\n";
+    uint32_t boot = 0;
+
+    crc8_init();
+
+    if (crash.magic == LOG_CRASH_MAGIC && crash.size == LOG_CRASH_SIZE && crash.crc == header_crc()) {
+        char chunk[64];
+        uint32_t head = crash.head;
+        uint32_t pos = crash_tail(head);
+        int length;
+
+        // Dump the previous boot's tail before this boot overwrites it
+        log_output_direct(banner, sizeof(banner) - 1, LOG_LEVEL_OFF);
+        while ((length = crash_next(&pos, head)) >= 0) {
+            pos += LOG_CRASH_HDR;
+            while (length > 0) {
+                size_t count = (size_t)length < sizeof(chunk) ? (size_t)length : sizeof(chunk);
+                crash_copy_out(chunk, pos, count);
+                log_output_direct(chunk, count, LOG_LEVEL_OFF);
+                pos += count;
+                length -= count;
+            }
+        }
+        log_output_direct(footer, sizeof(footer) - 1, LOG_LEVEL_OFF);
+        boot = crash.boot + 1;
+    }
+
+    crash.magic = LOG_CRASH_MAGIC;
+    crash.size = LOG_CRASH_SIZE;
+    crash.boot = boot;
+    crash.crc = header_crc();
+    crash.head = 0;
+}
+
+void log_crash_write(const char* message, size_t length)
+{
+    char header[LOG_CRASH_HDR];
+
+    if (length > LOG_CRASH_MAX_RECORD) {
+        message += length - LOG_CRASH_MAX_RECORD;
+        length = LOG_CRASH_MAX_RECORD;
+    }
+    header[0] = (char)LOG_CRASH_SYNC;
+    header[2] = (char)length;
+    header[3] = (char)(length >> 8);
+    header[1] = (char)crc8(crc8(0, &header[2], 2), message, length);
+
+    uint32_t head = __atomic_fetch_add(&crash.head, LOG_CRASH_HDR + length, __ATOMIC_RELAXED);
+    crash_copy_in(head, header, LOG_CRASH_HDR);
+    crash_copy_in(head + LOG_CRASH_HDR, message, length);
+}
+
+size_t log_crash_read(char* dst, size_t max)
+{
+    uint32_t head = __atomic_load_n(&crash.head, __ATOMIC_RELAXED);
+    uint32_t pos = crash_tail(head);
+    size_t total = 0, skip, done = 0;
+    int length;
+
+    // Payload bytes of the intact records, to return only the most recent
+    while ((length = crash_next(&pos, head)) >= 0) {
+        total += length;
+        pos += LOG_CRASH_HDR + length;
+    }
+    skip = total > max ? total - max : 0;
+
+    pos = crash_tail(head);
+    while (done < max && (length = crash_next(&pos, head)) >= 0) {
+        size_t from = skip < (size_t)length ? skip : (size_t)length;
+        size_t count = length - from;
+        if (count > max - done) {
+            count = max - done;
+        }
+        crash_copy_out(dst + done, pos + LOG_CRASH_HDR + from, count);
+        done += count;
+        skip -= from;
+        pos += LOG_CRASH_HDR + length;
+    }
+    return done;
+}
+
+uint32_t log_crash_boot_count(void)
+{
+    return crash.boot;
+}
@@ -0,0 +1,85 @@
+/*
+ * -----------------------------------------------------
+ *      __  __  _____  _____    _____
+ *     |  \/  ||_   _||  __ \  / ____|
+ *     | \  / |  | |  | |__) || (___
+ *     | |\/| |  | |  |  ___/  \___ \
+ *     | |  | | _| |_ | |      ____) |
+ *     |_|  |_||_____||_|     |_____/
+ * -----------------------------------------------------
+ * Copyright (c) 2025, MIPS All rights reserved.
+ * -----------------------------------------------------
+ */
+
+/**
+ * \file log_crash.h
+ * \brief Crash log ring that survives a reset.
+ *
+ * Every record is also copied into a fixed-size ring in the .noinit section,
+ * which start.S does not clear. log_init() validates the ring left by the
+ * previous boot, dumps its tail to the sinks and starts a new one. Used by
+ * log.c when LOG_CRASH_MODE is enabled; the linker script must provide a
+ * .noinit output section.
+ */
+
+#ifndef LOG_CRASH_H
+#define LOG_CRASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define LOG_CRASH_MAGIC 0x4C4F4743u /* "LOGC" */
+
+/* Ring capacity in bytes. Must be a power of two. */
+#ifndef LOG_CRASH_SIZE
+#define LOG_CRASH_SIZE 1024
+#endif
+
+#if (LOG_CRASH_SIZE & (LOG_CRASH_SIZE - 1)) != 0
+#error "LOG_CRASH_SIZE must be a power of two"
+#endif
+
+#if LOG_CRASH_SIZE > 65536
+#error "LOG_CRASH_SIZE must fit the 16-bit record length"
+#endif
+
+/**
+ * \brief Validate the previous boot's ring, dump it and start a new one.
+ *
+ * Called by log_init().
+ */
+void log_crash_init(void);
+
+/**
+ * \brief Append a record to the crash ring.
+ *
+ * Costs an atomic add, a table-driven CRC-8 over the record and a memcpy;
+ * safe from any context. Records longer than the ring keep their tail.
+ */
+void log_crash_write(const char* message, size_t length);
+
+/**
+ * \brief Copy the most recent record text of this boot's ring, oldest first.
+ *
+ * Record headers are stripped and records failing their CRC are skipped.
+ *
+ * \param dst Destination buffer.
+ * \param max Size of dst.
+ * \return Number of bytes copied.
+ */
+size_t log_crash_read(char* dst, size_t max);
+
+/**
+ * \brief Consecutive boots that found a valid ring, 0 after a cold start.
+ */
+uint32_t log_crash_boot_count(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* LOG_CRASH_H */
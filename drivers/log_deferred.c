@@ -0,0 +1,163 @@
+/*
+ * -----------------------------------------------------
+ *      __  __  _____  _____    _____
+ *     |  \/  ||_   _||  __ \  / ____|
+ *     | \  / |  | |  | |__) || (___
+ *     | |\/| |  | |  |  ___/  \___ \
+ *     | |  | | _| |_ | |      ____) |
+ *     |_|  |_||_____||_|     |_____/
+ * -----------------------------------------------------
+ * Copyright (c) 2025, MIPS All rights reserved.
+ * -----------------------------------------------------
+ */
+
+#include "log.h"
+#include "log_deferred.h"
+
+// Helper function to append a little endian value to the frame
+static int append_bytes(uint8_t* frame, size_t* offset, const void* value, size_t size)
+{
+    if (*offset + size > LOG_DEFERRED_MAX_FRAME) {
+        return -1;
+    }
+    memcpy(&frame[*offset], value, size);
+    *offset += size;
+    return 0;
+}
+
+#if LOG_TIMESTAMP_MODE
+/* Timestamp of the previous frame. Concurrent producers may race on it,
+    which only skews the deltas of the frames involved */
+static uint64_t last_timestamp;
+#endif
+
+// Append value as an unsigned LEB128 varint
+static int append_varint(uint8_t* frame, size_t* offset, uint64_t value)
+{
+    uint8_t bytes[10];
+    size_t n = 0;
+
+    // Most values fit 32 bits; keep 64-bit shifts off the common path on RV32
+    while (value >> 32) {
+        bytes[n++] = (uint8_t)value | 0x80;
+        value >>= 7;
+    }
+    uint32_t low = (uint32_t)value;
+    while (low >= 0x80) {
+        bytes[n++] = (uint8_t)low | 0x80;
+        low >>= 7;
+    }
+    bytes[n++] = (uint8_t)low;
+    return append_bytes(frame, offset, bytes, n);
+}
+
+#if LOG_DEFERRED_COMPACT
+// Append one argument: integers as (zigzag) varints, strings length-prefixed
+static int append_arg(uint8_t* frame, size_t* offset, uint32_t tag, va_list* args)
+{
+    switch (tag) {
+        case LOG_ARG_U64:
+            return append_varint(frame, offset, va_arg(*args, uint64_t));
+        case LOG_ARG_I64: {
+            int64_t value = va_arg(*args, int64_t);
+            return append_varint(frame, offset, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+        }
+        case LOG_ARG_I32: {
+            int32_t value = va_arg(*args, int32_t);
+            return append_varint(frame, offset, ((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+        }
+        case LOG_ARG_F64: {
+            double value = va_arg(*args, double);
+            return append_bytes(frame, offset, &value, sizeof(value));
+        }
+        case LOG_ARG_STR: {
+            const char* str = va_arg(*args, const char*);
+            size_t len = str ? strlen(str) : 0;
+            if (len > 255) {
+                len = 255;
+            }
+            return append_varint(frame, offset, len) | append_bytes(frame, offset, str, len);
+        }
+        case LOG_ARG_PTR:
+            return append_varint(frame, offset, (uint32_t)(uintptr_t)va_arg(*args, void*));
+        case LOG_ARG_U32:
+        default:
+            return append_varint(frame, offset, va_arg(*args, uint32_t));
+    }
+}
+#else
+// Append one argument at its fixed C size
+static int append_arg(uint8_t* frame, size_t* offset, uint32_t tag, va_list* args)
+{
+    switch (tag) {
+        case LOG_ARG_U64:
+        case LOG_ARG_I64: {
+            uint64_t value = va_arg(*args, uint64_t);
+            return append_bytes(frame, offset, &value, sizeof(value));
+        }
+        case LOG_ARG_F64: {
+            double value = va_arg(*args, double);
+            return append_bytes(frame, offset, &value, sizeof(value));
+        }
+        case LOG_ARG_STR: {
+            const char* str = va_arg(*args, const char*);
+            size_t len = str ? strlen(str) : 0;
+            if (len > 255) {
+                len = 255;
+            }
+            uint8_t len8 = len;
+            return append_bytes(frame, offset, &len8, 1) | append_bytes(frame, offset, str, len);
+        }
+        case LOG_ARG_PTR: {
+            uint32_t value = (uint32_t)(uintptr_t)va_arg(*args, void*);
+            return append_bytes(frame, offset, &value, sizeof(value));
+        }
+        case LOG_ARG_U32:
+        case LOG_ARG_I32:
+        default: {
+            uint32_t value = va_arg(*args, uint32_t);
+            return append_bytes(frame, offset, &value, sizeof(value));
+        }
+    }
+}
+#endif
+
+void log_deferred(int level, uint32_t id, uint32_t types, ...)
+{
+    va_list args;
+    uint8_t frame[LOG_DEFERRED_MAX_FRAME];
+    size_t offset = 2;
+    int err = 0;
+
+    va_start(args, types);
+
+#if LOG_DEFERRED_COMPACT
+    /* Entries are 4-byte aligned from address 0, so this stays small */
+    err |= append_varint(frame, &offset, id / 4);
+#else
+    err |= append_bytes(frame, &offset, &id, sizeof(id));
+#endif
+#if LOG_TIMESTAMP_MODE
+    uint64_t now = log_timestamp_raw();
+    err |= append_varint(frame, &offset, now - last_timestamp);
+    last_timestamp = now;
+#endif
+    size_t header = offset;
+
+    for (; types != LOG_ARG_END && !err; types >>= 4) {
+        err |= append_arg(frame, &offset, types & 0xF, &args);
+    }
+
+    va_end(args);
+
+    if (err) {
+        /* Arguments do not fit; the decoder reports the frame as truncated */
+        offset = header;
+        log_stats_truncated();
+    }
+
+    frame[0] = LOG_DEFERRED_COMPACT ? (LOG_TIMESTAMP_MODE ? LOG_DEFERRED_MAGIC_CTS : LOG_DEFERRED_MAGIC_C)
+                                    : (LOG_TIMESTAMP_MODE ? LOG_DEFERRED_MAGIC_TS : LOG_DEFERRED_MAGIC);
+    frame[1] = offset - 2;
+    log_output_record((const char*)frame, offset, level | LOG_RECORD_BINARY);
+}
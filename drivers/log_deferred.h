@@ -0,0 +1,153 @@
+/*
+ * -----------------------------------------------------
+ *      __  __  _____  _____    _____
+ *     |  \/  ||_   _||  __ \  / ____|
+ *     | \  / |  | |  | |__) || (___
+ *     | |\/| |  | |  |  ___/  \___ \
+ *     | |  | | _| |_ | |      ____) |
+ *     |_|  |_||_____||_|     |_____/
+ * -----------------------------------------------------
+ * Copyright (c) 2025, MIPS All rights reserved.
+ * -----------------------------------------------------
+ */
+
+/**
+ * \file log_deferred.h
+ * \brief Deferred binary logging.
+ *
+ * Format strings are interned in the non-loaded .logstr ELF section and only
+ * their section offset is sent, followed by the raw argument values. The host
+ * tool tools/log_decode.py reads the strings back from the ELF and renders
+ * the text. Included by log.h when LOG_DEFERRED_MODE is enabled.
+ *
+ * Frame layout (little endian):
+ *
+ *   LOG_DEFERRED_MAGIC | length (u8) | string id (u32) | arguments
+ *
+ * length counts the bytes after the length field. Arguments are encoded by
+ * their C type: 32-bit values and pointers as 4 bytes, 64-bit integers and
+ * doubles as 8 bytes, strings as a length byte followed by the characters.
+ *
+ * With LOG_TIMESTAMP_MODE the frame starts with LOG_DEFERRED_MAGIC_TS and
+ * the string id is followed by the log_timestamp_raw() ticks elapsed since
+ * the previous frame, as an unsigned LEB128 varint.
+ *
+ * LOG_DEFERRED_COMPACT selects the compact layout, which is what normally
+ * goes over the UART:
+ *
+ *   LOG_DEFERRED_MAGIC_C | length (u8) | string id / 4 (varint) | arguments
+ *
+ * Integers and pointers are LEB128 varints, signed ones zigzag encoded
+ * first; strings are a varint length followed by the characters; doubles
+ * stay 8 bytes. LOG_DEFERRED_MAGIC_CTS adds the timestamp delta as above.
+ * A typical record with two small arguments takes 6 to 9 bytes.
+ */
+
+#ifndef LOG_DEFERRED_H
+#define LOG_DEFERRED_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define LOG_DEFERRED_MAGIC     0xA5
+#define LOG_DEFERRED_MAGIC_TS  0xA6 /** Frame with a timestamp delta */
+#define LOG_DEFERRED_MAGIC_C   0xA7 /** Compact frame */
+#define LOG_DEFERRED_MAGIC_CTS 0xA8 /** Compact frame with a timestamp delta */
+
+/* Use the compact varint layout instead of fixed-size arguments */
+#ifndef LOG_DEFERRED_COMPACT
+#define LOG_DEFERRED_COMPACT 1
+#endif
+
+/* Largest encoded frame, in bytes */
+#ifndef LOG_DEFERRED_MAX_FRAME
+#define LOG_DEFERRED_MAX_FRAME 64
+#endif
+
+/**
+ * \brief Argument type tags, packed four bits per argument.
+ */
+#define LOG_ARG_END 0 /** No more arguments */
+#define LOG_ARG_U32 1 /** 32-bit unsigned integer or char */
+#define LOG_ARG_U64 2 /** 64-bit unsigned integer */
+#define LOG_ARG_F64 3 /** float or double */
+#define LOG_ARG_STR 4 /** NUL terminated string, copied into the frame */
+#define LOG_ARG_PTR 5 /** Pointer, sent as its low 32 bits */
+#define LOG_ARG_I32 6 /** 32-bit signed integer */
+#define LOG_ARG_I64 7 /** 64-bit signed integer */
+
+#define LOG_MAX_DEFERRED_ARGS 8
+
+#define LOG_ARG_TYPE(x) ((uint32_t)_Generic((x), \
+    char*: LOG_ARG_STR, \
+    const char*: LOG_ARG_STR, \
+    signed char: LOG_ARG_I32, \
+    short: LOG_ARG_I32, \
+    int: LOG_ARG_I32, \
+    long: (sizeof(long) == 8 ? LOG_ARG_I64 : LOG_ARG_I32), \
+    unsigned long: (sizeof(long) == 8 ? LOG_ARG_U64 : LOG_ARG_U32), \
+    long long: LOG_ARG_I64, \
+    unsigned long long: LOG_ARG_U64, \
+    float: LOG_ARG_F64, \
+    double: LOG_ARG_F64, \
+    void*: LOG_ARG_PTR, \
+    const void*: LOG_ARG_PTR, \
+    default: LOG_ARG_U32))
+
+#define LOG_CAT_(a, b) a##b
+#define LOG_CAT(a, b) LOG_CAT_(a, b)
+/* Counts up to 16 so that callers can reject more than
+    LOG_MAX_DEFERRED_ARGS with a readable message */
+#define LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, N, ...) N
+#define LOG_NARGS(...) LOG_NARGS_(0, ##__VA_ARGS__, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+
+#define LOG_ARG_TYPES_0() LOG_ARG_END
+#define LOG_ARG_TYPES_1(a) LOG_ARG_TYPE(a)
+#define LOG_ARG_TYPES_2(a, ...) (LOG_ARG_TYPE(a) | (LOG_ARG_TYPES_1(__VA_ARGS__) << 4))
+#define LOG_ARG_TYPES_3(a, ...) (LOG_ARG_TYPE(a) | (LOG_ARG_TYPES_2(__VA_ARGS__) << 4))
+#define LOG_ARG_TYPES_4(a, ...) (LOG_ARG_TYPE(a) | (LOG_ARG_TYPES_3(__VA_ARGS__) << 4))
+#define LOG_ARG_TYPES_5(a, ...) (LOG_ARG_TYPE(a) | (LOG_ARG_TYPES_4(__VA_ARGS__) << 4))
+#define LOG_ARG_TYPES_6(a, ...) (LOG_ARG_TYPE(a) | (LOG_ARG_TYPES_5(__VA_ARGS__) << 4))
+#define LOG_ARG_TYPES_7(a, ...) (LOG_ARG_TYPE(a) | (LOG_ARG_TYPES_6(__VA_ARGS__) << 4))
+#define LOG_ARG_TYPES_8(a, ...) (LOG_ARG_TYPE(a) | (LOG_ARG_TYPES_7(__VA_ARGS__) << 4))
+
+/* Pack the type tags of up to LOG_MAX_DEFERRED_ARGS arguments into one word */
+#define LOG_ARG_TYPES(...) LOG_CAT(LOG_ARG_TYPES_, LOG_NARGS(__VA_ARGS__))(__VA_ARGS__)
+
+/*
+ * Intern a call site in .logstr. The entry holds the argument types, the
+ * line number and "tag\0file\0format"; the address of the entry within the
+ * section is the string id.
+ */
+#define LOG_DEFERRED(level, tag, fmt, ...) do { \
+    static const struct { \
+        uint32_t types; \
+        uint32_t line; \
+        char str[sizeof(tag "\0" __FILE_NAME__ "\0" fmt)]; \
+    } log_str_ __attribute__((section(".logstr"), used, aligned(4))) = { \
+        LOG_ARG_TYPES(__VA_ARGS__), __LINE__, tag "\0" __FILE_NAME__ "\0" fmt \
+    }; \
+    log_deferred(level, (uint32_t)(uintptr_t)&log_str_, LOG_ARG_TYPES(__VA_ARGS__), ##__VA_ARGS__); \
+} while (0)
+
+/**
+ * \brief Encode and output a deferred log frame.
+ *
+ * Normally called through the LOG_* macros, never directly.
+ *
+ * \param level LOG_LEVEL_* of the record, for the sinks.
+ * \param id    Offset of the call site entry in .logstr.
+ * \param types Argument type tags from LOG_ARG_TYPES().
+ * \param ...   Arguments.
+ */
+void log_deferred(int level, uint32_t id, uint32_t types, ...);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* LOG_DEFERRED_H */
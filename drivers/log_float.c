@@ -0,0 +1,345 @@
+/*
+ * -----------------------------------------------------
+ *      __  __  _____  _____    _____
+ *     |  \/  ||_   _||  __ \  / ____|
+ *     | \  / |  | |  | |__) || (___
+ *     | |\/| |  | |  |  ___/  \___ \
+ *     | |  | | _| |_ | |      ____) |
+ *     |_|  |_||_____||_|     |_____/
+ * -----------------------------------------------------
+ * Copyright (c) 2025, MIPS All rights reserved.
+ * -----------------------------------------------------
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "log_float.h"
+
+/*
+ * Grisu2 (Loitsch, "Printing Floating-Point Numbers Quickly and Accurately
+ * with Integers"). The value and its rounding boundaries are scaled by a
+ * cached power of ten so that the scaled upper boundary has its binary point
+ * between bits 28 and 60. Digits are then taken from the integer part and
+ * the fraction until the remaining uncertainty is smaller than the distance
+ * to the boundaries, and the last digit is nudged towards the exact value.
+ */
+
+typedef struct {
+    uint64_t f;
+    int e;
+} diy_fp_t;
+
+#define DP_SIGNIFICAND_SIZE 52
+#define DP_EXPONENT_BIAS    (0x3FF + DP_SIGNIFICAND_SIZE)
+#define DP_HIDDEN_BIT       (1ull << DP_SIGNIFICAND_SIZE)
+#define DP_SIGNIFICAND_MASK (DP_HIDDEN_BIT - 1)
+
+/* 10^k for k = -348, -340, ... 340, normalised to 64 bits: 10^k ~= f * 2^e */
+#define CACHED_POWER_MIN_K (-348)
+#define CACHED_POWER_STEP  8
+
+static const uint64_t cached_power_f[] = {
+    0xFA8FD5A0081C0288ull, 0xBAAEE17FA23EBF76ull, 0x8B16FB203055AC76ull,
+    0xCF42894A5DCE35EAull, 0x9A6BB0AA55653B2Dull, 0xE61ACF033D1A45DFull,
+    0xAB70FE17C79AC6CAull, 0xFF77B1FCBEBCDC4Full, 0xBE5691EF416BD60Cull,
+    0x8DD01FAD907FFC3Cull, 0xD3515C2831559A83ull, 0x9D71AC8FADA6C9B5ull,
+    0xEA9C227723EE8BCBull, 0xAECC49914078536Dull, 0x823C12795DB6CE57ull,
+    0xC21094364DFB5637ull, 0x9096EA6F3848984Full, 0xD77485CB25823AC7ull,
+    0xA086CFCD97BF97F4ull, 0xEF340A98172AACE5ull, 0xB23867FB2A35B28Eull,
+    0x84C8D4DFD2C63F3Bull, 0xC5DD44271AD3CDBAull, 0x936B9FCEBB25C996ull,
+    0xDBAC6C247D62A584ull, 0xA3AB66580D5FDAF6ull, 0xF3E2F893DEC3F126ull,
+    0xB5B5ADA8AAFF80B8ull, 0x87625F056C7C4A8Bull, 0xC9BCFF6034C13053ull,
+    0x964E858C91BA2655ull, 0xDFF9772470297EBDull, 0xA6DFBD9FB8E5B88Full,
+    0xF8A95FCF88747D94ull, 0xB94470938FA89BCFull, 0x8A08F0F8BF0F156Bull,
+    0xCDB02555653131B6ull, 0x993FE2C6D07B7FACull, 0xE45C10C42A2B3B06ull,
+    0xAA242499697392D3ull, 0xFD87B5F28300CA0Eull, 0xBCE5086492111AEBull,
+    0x8CBCCC096F5088CCull, 0xD1B71758E219652Cull, 0x9C40000000000000ull,
+    0xE8D4A51000000000ull, 0xAD78EBC5AC620000ull, 0x813F3978F8940984ull,
+    0xC097CE7BC90715B3ull, 0x8F7E32CE7BEA5C70ull, 0xD5D238A4ABE98068ull,
+    0x9F4F2726179A2245ull, 0xED63A231D4C4FB27ull, 0xB0DE65388CC8ADA8ull,
+    0x83C7088E1AAB65DBull, 0xC45D1DF942711D9Aull, 0x924D692CA61BE758ull,
+    0xDA01EE641A708DEAull, 0xA26DA3999AEF774Aull, 0xF209787BB47D6B85ull,
+    0xB454E4A179DD1877ull, 0x865B86925B9BC5C2ull, 0xC83553C5C8965D3Dull,
+    0x952AB45CFA97A0B3ull, 0xDE469FBD99A05FE3ull, 0xA59BC234DB398C25ull,
+    0xF6C69A72A3989F5Cull, 0xB7DCBF5354E9BECEull, 0x88FCF317F22241E2ull,
+    0xCC20CE9BD35C78A5ull, 0x98165AF37B2153DFull, 0xE2A0B5DC971F303Aull,
+    0xA8D9D1535CE3B396ull, 0xFB9B7CD9A4A7443Cull, 0xBB764C4CA7A44410ull,
+    0x8BAB8EEFB6409C1Aull, 0xD01FEF10A657842Cull, 0x9B10A4E5E9913129ull,
+    0xE7109BFBA19C0C9Dull, 0xAC2820D9623BF429ull, 0x80444B5E7AA7CF85ull,
+    0xBF21E44003ACDD2Dull, 0x8E679C2F5E44FF8Full, 0xD433179D9C8CB841ull,
+    0x9E19DB92B4E31BA9ull, 0xEB96BF6EBADF77D9ull, 0xAF87023B9BF0EE6Bull,
+};
+
+static const int16_t cached_power_e[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+    -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+    -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+    -422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+    -157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+    109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+    641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+    907, 933, 960, 986, 1013, 1039, 1066,
+};
+
+static const uint64_t pow10_table[20] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull,
+    100000000ull, 1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull,
+    10000000000000ull, 100000000000000ull, 1000000000000000ull, 10000000000000000ull,
+    100000000000000000ull, 1000000000000000000ull, 10000000000000000000ull,
+};
+
+// Upper 64 bits of the 128-bit product, rounded, from 32-bit halves
+static diy_fp_t diy_fp_mul(diy_fp_t x, diy_fp_t y)
+{
+    uint64_t a = x.f >> 32, b = (uint32_t)x.f;
+    uint64_t c = y.f >> 32, d = (uint32_t)y.f;
+    uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    uint64_t mid = (bd >> 32) + (uint32_t)ad + (uint32_t)bc + (1ull << 31);
+    diy_fp_t r = { ac + (ad >> 32) + (bc >> 32) + (mid >> 32), x.e + y.e + 64 };
+    return r;
+}
+
+static diy_fp_t diy_fp_normalize(diy_fp_t x)
+{
+    int shift = __builtin_clzll(x.f);
+    x.f <<= shift;
+    x.e -= shift;
+    return x;
+}
+
+// Cached power c = 10^-k such that the product with a normalised e lands in [-60, -32]
+static diy_fp_t cached_power(int e, int* k)
+{
+    /* ceil((-61 - e) * log10(2)), with log10(2) ~= 78913 / 2^18 */
+    int dk = -61 - e;
+    int ceil_k = (dk * 78913 + (1 << 18) - 1) >> 18;
+    int index = (ceil_k - CACHED_POWER_MIN_K + CACHED_POWER_STEP - 1) / CACHED_POWER_STEP;
+    diy_fp_t c = { cached_power_f[index], cached_power_e[index] };
+
+    *k = -(CACHED_POWER_MIN_K + index * CACHED_POWER_STEP);
+    return c;
+}
+
+static int count_digits32(uint32_t n)
+{
+    int count = 1;
+    while (count < 10 && n >= pow10_table[count]) {
+        count++;
+    }
+    return count;
+}
+
+static void grisu_round(char* digits, int length, uint64_t delta, uint64_t rest, uint64_t ten_kappa, uint64_t wp_w)
+{
+    while (rest < wp_w && delta - rest >= ten_kappa &&
+           (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w)) {
+        digits[length - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+static int digit_gen(diy_fp_t w, diy_fp_t mp, uint64_t delta, char* digits, int* k)
+{
+    int shift = -mp.e;
+    uint64_t one = 1ull << shift;
+    uint64_t wp_w = mp.f - w.f;
+    uint32_t p1 = (uint32_t)(mp.f >> shift);
+    uint64_t p2 = mp.f & (one - 1);
+    int kappa = count_digits32(p1);
+    int length = 0;
+
+    // Integer part
+    while (kappa > 0) {
+        uint32_t divisor = (uint32_t)pow10_table[kappa - 1];
+        uint32_t d = p1 / divisor;
+        p1 -= d * divisor;
+        if (d || length) {
+            digits[length++] = '0' + d;
+        }
+        kappa--;
+        uint64_t rest = ((uint64_t)p1 << shift) + p2;
+        if (rest <= delta) {
+            *k += kappa;
+            grisu_round(digits, length, delta, rest, pow10_table[kappa] << shift, wp_w);
+            return length;
+        }
+    }
+
+    // Fraction
+    for (;;) {
+        p2 *= 10;
+        delta *= 10;
+        char d = (char)(p2 >> shift);
+        if (d || length) {
+            digits[length++] = '0' + d;
+        }
+        p2 &= one - 1;
+        kappa--;
+        if (p2 < delta) {
+            *k += kappa;
+            grisu_round(digits, length, delta, p2, one, (-kappa < 20) ? wp_w * pow10_table[-kappa] : 0);
+            return length;
+        }
+    }
+}
+
+int log_float_digits(double value, char* digits, int* exponent)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    int biased = (int)((bits >> DP_SIGNIFICAND_SIZE) & 0x7FF);
+    diy_fp_t v = { bits & DP_SIGNIFICAND_MASK, 1 - DP_EXPONENT_BIAS };
+    if (biased != 0) {
+        v.f += DP_HIDDEN_BIT;
+        v.e = biased - DP_EXPONENT_BIAS;
+    }
+
+    // Boundaries halfway to the neighbouring doubles, on a common exponent
+    diy_fp_t plus = { (v.f << 1) + 1, v.e - 1 };
+    plus = diy_fp_normalize(plus);
+    diy_fp_t minus;
+    if (v.f == DP_HIDDEN_BIT && biased > 1) {
+        /* Lower neighbour is closer at a power of two */
+        minus.f = (v.f << 2) - 1;
+        minus.e = v.e - 2;
+    } else {
+        minus.f = (v.f << 1) - 1;
+        minus.e = v.e - 1;
+    }
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+
+    int k;
+    diy_fp_t c = cached_power(plus.e, &k);
+    diy_fp_t w = diy_fp_mul(diy_fp_normalize(v), c);
+    diy_fp_t wp = diy_fp_mul(plus, c);
+    diy_fp_t wm = diy_fp_mul(minus, c);
+    wm.f++;
+    wp.f--;
+
+    int length = digit_gen(w, wp, wp.f - wm.f, digits, &k);
+    while (length > 1 && digits[length - 1] == '0') {
+        length--;
+        k++;
+    }
+    *exponent = k + length - 1;
+    return length;
+}
+
+/*
+ * Exact comparison for the rare ties: both sides are scaled to integers,
+ * m * 2^e against n * 5^k * 2^k, in a little-endian array of 32-bit words.
+ * The largest product, a subnormal against 17 digits at 10^-340, needs
+ * about 850 bits.
+ */
+#define BIG_WORDS 40
+
+typedef struct {
+    uint32_t w[BIG_WORDS];
+    int n;
+} big_t;
+
+static void big_set(big_t* b, uint64_t v)
+{
+    b->w[0] = (uint32_t)v;
+    b->w[1] = (uint32_t)(v >> 32);
+    b->n = (v >> 32) ? 2 : (v ? 1 : 0);
+}
+
+static void big_mul(big_t* b, uint32_t m)
+{
+    uint64_t carry = 0;
+    for (int i = 0; i < b->n; i++) {
+        carry += (uint64_t)b->w[i] * m;
+        b->w[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+    if (carry) {
+        b->w[b->n++] = (uint32_t)carry;
+    }
+}
+
+static void big_mul_pow5(big_t* b, int e)
+{
+    for (; e >= 13; e -= 13) {
+        big_mul(b, 1220703125u);  /* 5^13 */
+    }
+    uint32_t m = 1;
+    while (e--) {
+        m *= 5;
+    }
+    big_mul(b, m);
+}
+
+static void big_shl(big_t* b, int shift)
+{
+    int words = shift / 32, bits = shift % 32;
+
+    if (b->n == 0) {
+        return;
+    }
+    b->w[b->n] = 0;
+    for (int i = b->n; i >= 0; i--) {
+        uint32_t hi = b->w[i] << bits;
+        uint32_t lo = (bits && i > 0) ? b->w[i - 1] >> (32 - bits) : 0;
+        b->w[i + words] = hi | lo;
+    }
+    for (int i = 0; i < words; i++) {
+        b->w[i] = 0;
+    }
+    b->n += words + 1;
+    while (b->n > 0 && b->w[b->n - 1] == 0) {
+        b->n--;
+    }
+}
+
+static int big_cmp(const big_t* a, const big_t* b)
+{
+    if (a->n != b->n) {
+        return a->n < b->n ? -1 : 1;
+    }
+    for (int i = a->n - 1; i >= 0; i--) {
+        if (a->w[i] != b->w[i]) {
+            return a->w[i] < b->w[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+int log_float_compare(double value, const char* digits, int count, int exponent)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    int biased = (int)((bits >> DP_SIGNIFICAND_SIZE) & 0x7FF);
+    diy_fp_t v = { bits & DP_SIGNIFICAND_MASK, 1 - DP_EXPONENT_BIAS };
+    if (biased != 0) {
+        v.f += DP_HIDDEN_BIT;
+        v.e = biased - DP_EXPONENT_BIAS;
+    }
+
+    uint64_t n = 0;
+    for (int i = 0; i < count; i++) {
+        n = n * 10 + (digits[i] - '0');
+    }
+    int k = exponent - (count - 1);
+
+    // v.f * 2^v.e against n * 5^k * 2^k, with negative powers moved across
+    big_t lhs, rhs;
+    big_set(&lhs, v.f);
+    big_set(&rhs, n);
+    if (k >= 0) {
+        big_mul_pow5(&rhs, k);
+    } else {
+        big_mul_pow5(&lhs, -k);
+    }
+    int shift = v.e - k;
+    if (shift >= 0) {
+        big_shl(&lhs, shift);
+    } else {
+        big_shl(&rhs, -shift);
+    }
+    return big_cmp(&lhs, &rhs);
+}
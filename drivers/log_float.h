@@ -0,0 +1,65 @@
+/*
+ * -----------------------------------------------------
+ *      __  __  _____  _____    _____
+ *     |  \/  ||_   _||  __ \  / ____|
+ *     | \  / |  | |  | |__) || (___
+ *     | |\/| |  | |  |  ___/  \___ \
+ *     | |  | | _| |_ | |      ____) |
+ *     |_|  |_||_____||_|     |_____/
+ * -----------------------------------------------------
+ * Copyright (c) 2025, MIPS All rights reserved.
+ * -----------------------------------------------------
+ */
+
+/**
+ * \file log_float.h
+ * \brief Shortest round-trip digits of a double, for %f/%e/%g.
+ *
+ * Grisu2 digit generation using only integer arithmetic and a table of
+ * cached powers of ten, without newlib's dtoa. Used by log.c when
+ * LOG_FLOAT_MODE is enabled; only builds that set it need to link this file.
+ */
+
+#ifndef LOG_FLOAT_H
+#define LOG_FLOAT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Most significant digits log_float_digits() produces */
+#define LOG_FLOAT_DIGITS 17
+
+/**
+ * \brief Decimal digits of a finite, non-zero double.
+ *
+ * The digits, read as d.ddd x 10^exponent, convert back to exactly the
+ * same double, and there is almost always no shorter string that does.
+ *
+ * \param value    Value to convert; the sign is ignored.
+ * \param digits   Receives the ASCII digits, without trailing zeros and
+ *                 not NUL terminated. Must hold LOG_FLOAT_DIGITS bytes.
+ * \param exponent Receives the decimal exponent of the first digit.
+ * \return Number of digits written.
+ */
+int log_float_digits(double value, char* digits, int* exponent);
+
+/**
+ * \brief Compare a double with a decimal exactly.
+ *
+ * Slow, arbitrary precision; used to break ties when rounding digits.
+ *
+ * \param value    Finite, non-zero value; the sign is ignored.
+ * \param digits   ASCII digits d.ddd, at most LOG_FLOAT_DIGITS.
+ * \param count    Number of digits.
+ * \param exponent Decimal exponent of the first digit.
+ * \return Negative, zero or positive as value is below, equal to or above
+ *         the decimal.
+ */
+int log_float_compare(double value, const char* digits, int count, int exponent);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* LOG_FLOAT_H */
@@ -0,0 +1,170 @@
+/*
+ * -----------------------------------------------------
+ *      __  __  _____  _____    _____
+ *     |  \/  ||_   _||  __ \  / ____|
+ *     | \  / |  | |  | |__) || (___
+ *     | |\/| |  | |  |  ___/  \___ \
+ *     | |  | | _| |_ | |      ____) |
+ *     |_|  |_||_____||_|     |_____/
+ * -----------------------------------------------------
+ * Copyright (c) 2025, MIPS All rights reserved.
+ * -----------------------------------------------------
+ */
+
+#include "log.h"
+#include "log_ring.h"
+#include "log_isr.h"
+#include "log_freertos.h"
+#include "freertos_context.h"
+#include "semphr.h"
+
+/* Per-task record buffer, reached through a thread local storage pointer */
+typedef struct {
+    uint32_t bytes;
+    uint32_t records;
+    uint32_t in_use;
+    uint32_t partial;   /* Output lock held across a chunked record */
+    uint32_t depth;     /* Nonzero while a record is being committed */
+    char buffer[configLOG_STAGING_BUFFER_SIZE];
+} log_staging_t;
+
+static log_staging_t staging_pool[configLOG_STAGING_POOL_SIZE];
+
+#if !LOG_ASYNC_MODE
+/* Serializes synchronous records on the UART; recursive so that a sink
+    that logs from inside log_output_record() does not deadlock. That
+    nested record is formatted on the stack, see log_staging_acquire() */
+static StaticSemaphore_t output_lock_buffer;
+static SemaphoreHandle_t output_lock;
+#endif
+
+static StaticTask_t drain_task_tcb;
+static StackType_t drain_task_stack[LOG_DRAIN_TASK_STACK_SIZE];
+
+static void log_drain_task(void* pvParameters)
+{
+    (void)pvParameters;
+
+    for (;;) {
+        size_t records = log_isr_drain();
+        if (log_ring_drain() == 0 && records == 0) {
+            vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_PERIOD_MS));
+        }
+    }
+}
+
+/* Blocked writers sleep for a tick so the drain task can run. Interrupt
+    handlers, critical sections and code before the scheduler must not
+    block, so their writer drops the record instead */
+int log_ring_wait_hook(void)
+{
+    if (!freertos_in_task_context()) {
+        return 0;
+    }
+    vTaskDelay(1);
+    return 1;
+}
+
+static log_staging_t* log_staging_claim(void)
+{
+    for (int i = 0; i < configLOG_STAGING_POOL_SIZE; i++) {
+        if (__atomic_exchange_n(&staging_pool[i].in_use, 1, __ATOMIC_ACQUIRE) == 0) {
+            staging_pool[i].bytes = 0;
+            staging_pool[i].records = 0;
+            return &staging_pool[i];
+        }
+    }
+    return NULL;
+}
+
+// Staging buffers belong to tasks; interrupt handlers and critical
+// sections (MIE clear) and code running before the scheduler use the stack.
+// So does a record logged by a sink while the task's own record is being
+// committed, as it would otherwise overwrite the buffer being written out
+char* log_staging_acquire(size_t* size)
+{
+    if (!freertos_in_task_context()) {
+        return NULL;
+    }
+
+    log_staging_t* staging = pvTaskGetThreadLocalStoragePointer(NULL, configLOG_STAGING_TLS_INDEX);
+    if (staging != NULL && staging->depth != 0) {
+        return NULL;
+    }
+    if (staging == NULL) {
+        staging = log_staging_claim();
+        if (staging == NULL) {
+            return NULL;
+        }
+        vTaskSetThreadLocalStoragePointer(NULL, configLOG_STAGING_TLS_INDEX, staging);
+    }
+
+    *size = sizeof(staging->buffer);
+    return staging->buffer;
+}
+
+void log_staging_commit(const char* record, size_t length, int attr)
+{
+    log_staging_t* staging = pvTaskGetThreadLocalStoragePointer(NULL, configLOG_STAGING_TLS_INDEX);
+
+    staging->depth++;
+#if LOG_ASYNC_MODE
+    /* A ring reservation is already atomic per record */
+    log_output_record(record, length, attr);
+#else
+    /* Keep other tasks off the UART until the whole record is out,
+        including every chunk of one longer than the staging buffer. A
+        mutex rather than a suspended scheduler, so higher priority tasks
+        that do not log keep running during the write */
+    if (!staging->partial) {
+        (void)xSemaphoreTakeRecursive(output_lock, portMAX_DELAY);
+    }
+    log_output_record(record, length, attr);
+    staging->partial = (attr & LOG_RECORD_MORE) != 0;
+    if (!staging->partial) {
+        (void)xSemaphoreGiveRecursive(output_lock);
+    }
+#endif
+    staging->depth--;
+
+    staging->bytes += length;
+    if (!(attr & LOG_RECORD_MORE)) {
+        staging->records++;
+    }
+}
+
+BaseType_t log_task_stats(TaskHandle_t task, uint32_t* bytes, uint32_t* records)
+{
+    log_staging_t* staging = pvTaskGetThreadLocalStoragePointer(task, configLOG_STAGING_TLS_INDEX);
+
+    if (staging == NULL) {
+        return pdFALSE;
+    }
+    *bytes = staging->bytes;
+    *records = staging->records;
+    return pdTRUE;
+}
+
+void log_task_release(void)
+{
+    log_staging_t* staging = pvTaskGetThreadLocalStoragePointer(NULL, configLOG_STAGING_TLS_INDEX);
+
+    if (staging != NULL) {
+        vTaskSetThreadLocalStoragePointer(NULL, configLOG_STAGING_TLS_INDEX, NULL);
+        __atomic_store_n(&staging->in_use, 0, __ATOMIC_RELEASE);
+    }
+}
+
+void log_freertos_init(void)
+{
+#if !LOG_ASYNC_MODE
+    output_lock = xSemaphoreCreateRecursiveMutexStatic(&output_lock_buffer);
+#endif
+    xTaskCreateStatic(log_drain_task,
+                      "LogDrain",
+                      LOG_DRAIN_TASK_STACK_SIZE,
+                      NULL,
+                      LOG_DRAIN_TASK_PRIORITY,
+                      drain_task_stack,
+                      &drain_task_tcb);
+}
@@ -0,0 +1,99 @@
+/*
+ * -----------------------------------------------------
+ *      __  __  _____  _____    _____
+ *     |  \/  ||_   _||  __ \  / ____|
+ *     | \  / |  | |  | |__) || (___
+ *     | |\/| |  | |  |  ___/  \___ \
+ *     | |  | | _| |_ | |      ____) |
+ *     |_|  |_||_____||_|     |_____/
+ * -----------------------------------------------------
+ * Copyright (c) 2025, MIPS All rights reserved.
+ * -----------------------------------------------------
+ */
+
+/**
+ * \file log_freertos.h
+ * \brief FreeRTOS integration for the logging system.
+ */
+
+#ifndef LOG_FREERTOS_H
+#define LOG_FREERTOS_H
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "log.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Priority of the task draining the asynchronous log ring */
+#ifndef LOG_DRAIN_TASK_PRIORITY
+#define LOG_DRAIN_TASK_PRIORITY tskIDLE_PRIORITY
+#endif
+
+/* Stack depth of the drain task, in words */
+#ifndef LOG_DRAIN_TASK_STACK_SIZE
+#define LOG_DRAIN_TASK_STACK_SIZE (configMINIMAL_STACK_SIZE * 2)
+#endif
+
+/* Sleep time of the drain task once the ring is empty */
+#ifndef LOG_DRAIN_PERIOD_MS
+#define LOG_DRAIN_PERIOD_MS 10
+#endif
+
+/* Size of each task's log staging buffer */
+#ifndef configLOG_STAGING_BUFFER_SIZE
+#define configLOG_STAGING_BUFFER_SIZE LOG_BUFFER_SIZE
+#endif
+
+/* Number of tasks that can hold a staging buffer at the same time; other
+    tasks format on their own stack */
+#ifndef configLOG_STAGING_POOL_SIZE
+#define configLOG_STAGING_POOL_SIZE 4
+#endif
+
+/* Thread local storage slot holding the task's staging buffer */
+#ifndef configLOG_STAGING_TLS_INDEX
+#define configLOG_STAGING_TLS_INDEX 0
+#endif
+
+#if configNUM_THREAD_LOCAL_STORAGE_POINTERS <= configLOG_STAGING_TLS_INDEX
+#error "configNUM_THREAD_LOCAL_STORAGE_POINTERS must cover configLOG_STAGING_TLS_INDEX"
+#endif
+
+#if !LOG_ASYNC_MODE && !configUSE_RECURSIVE_MUTEXES
+#error "Synchronous logging needs configUSE_RECURSIVE_MUTEXES for its output lock"
+#endif
+
+/**
+ * \brief Start the FreeRTOS side of the logging system.
+ *
+ * Creates the low-priority task that drains the asynchronous log ring
+ * and, in synchronous mode, the lock that keeps records whole on the
+ * UART. Call after log_init() and before vTaskStartScheduler().
+ */
+void log_freertos_init(void);
+
+/**
+ * \brief Read the logging counters of a task.
+ *
+ * \param task    Task handle, or NULL for the calling task.
+ * \param bytes   Set to the number of bytes the task has logged.
+ * \param records Set to the number of records the task has logged.
+ * \return pdTRUE, or pdFALSE if the task has no staging buffer.
+ */
+BaseType_t log_task_stats(TaskHandle_t task, uint32_t* bytes, uint32_t* records);
+
+/**
+ * \brief Return the calling task's staging buffer to the pool.
+ *
+ * Call before a task deletes itself; its counters are discarded.
+ */
+void log_task_release(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* LOG_FREERTOS_H */
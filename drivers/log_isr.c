@@ -0,0 +1,167 @@
+/*
+ * -----------------------------------------------------
+ *      __  __  _____  _____    _____
+ *     |  \/  ||_   _||  __ \  / ____|
+ *     | \  / |  | |  | |__) || (___
+ *     | |\/| |  | |  |  ___/  \___ \
+ *     | |  | | _| |_ | |      ____) |
+ *     |_|  |_||_____||_|     |_____/
+ * -----------------------------------------------------
+ * Copyright (c) 2025, MIPS All rights reserved.
+ * -----------------------------------------------------
+ */
+
+#include "log_isr.h"
+
+#define LOG_ISR_MASK (LOG_ISR_QUEUE_LEN - 1)
+
+/*
+ * Bounded queue of fixed slots (Vyukov style). A slot whose seq equals the
+ * head position is free; a producer claims it by advancing head with a CAS,
+ * fills it, and publishes it by setting seq to position + 1. The consumer
+ * takes the slot at tail once seq is tail + 1 and frees it for the next lap
+ * by setting seq to tail + LOG_ISR_QUEUE_LEN. seq is stored minus the slot
+ * index so the zeroed queue starts out with every slot free.
+ */
+typedef struct {
+    uint32_t seq;
+    int level;
+    const char* fmt;
+    log_word_t words[LOG_ISR_MAX_WORDS];
+} log_isr_slot_t;
+
+static log_isr_slot_t slots[LOG_ISR_QUEUE_LEN];
+static uint32_t head;
+static uint32_t tail;
+static uint32_t dropped;
+
+static inline uint32_t slot_seq(uint32_t pos)
+{
+    return __atomic_load_n(&slots[pos & LOG_ISR_MASK].seq, __ATOMIC_ACQUIRE) + (pos & LOG_ISR_MASK);
+}
+
+static inline void slot_set_seq(uint32_t pos, uint32_t seq)
+{
+    __atomic_store_n(&slots[pos & LOG_ISR_MASK].seq, seq - (pos & LOG_ISR_MASK), __ATOMIC_RELEASE);
+}
+
+// Encode the arguments into words; returns -1 if they do not fit
+static int log_isr_encode(log_word_t* words, uint32_t types, va_list* args)
+{
+    int n = 0;
+
+    for (; types != LOG_ARG_END; types >>= 4) {
+        uint64_t value;
+
+        switch (types & 0xF) {
+            case LOG_ARG_U64:
+            case LOG_ARG_I64:
+                value = va_arg(*args, uint64_t);
+                break;
+            case LOG_ARG_F64: {
+                double d = va_arg(*args, double);
+                memcpy(&value, &d, sizeof(value));
+                break;
+            }
+            case LOG_ARG_STR:
+            case LOG_ARG_PTR:
+                value = (uintptr_t)va_arg(*args, void*);
+                break;
+            case LOG_ARG_U32:
+            default:
+                value = va_arg(*args, uint32_t);
+                break;
+        }
+
+        if (n >= LOG_ISR_MAX_WORDS) {
+            return -1;
+        }
+        words[n++] = (log_word_t)value;
+        if ((types & 0xF) == LOG_ARG_U64 || (types & 0xF) == LOG_ARG_I64 || (types & 0xF) == LOG_ARG_F64) {
+            if (sizeof(log_word_t) < sizeof(uint64_t)) {
+                if (n >= LOG_ISR_MAX_WORDS) {
+                    return -1;
+                }
+                words[n++] = (log_word_t)(value >> 32);
+            }
+        }
+    }
+    return 0;
+}
+
+void log_isr_record(int level, const char* fmt, uint32_t types, ...)
+{
+    va_list args;
+    log_isr_slot_t* slot;
+    uint32_t pos;
+
+    // Claim a slot; retries only when a nested handler claimed the same one
+    pos = __atomic_load_n(&head, __ATOMIC_RELAXED);
+    for (;;) {
+        slot = &slots[pos & LOG_ISR_MASK];
+        int32_t diff = (int32_t)(slot_seq(pos) - pos);
+        if (diff < 0) {
+            /* Queue full */
+            __atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        if (diff == 0 && __atomic_compare_exchange_n(&head, &pos, pos + 1,
+                                                     1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            break;
+        }
+        if (diff > 0) {
+            pos = __atomic_load_n(&head, __ATOMIC_RELAXED);
+        }
+    }
+
+    va_start(args, types);
+    int err = log_isr_encode(slot->words, types, &args);
+    va_end(args);
+
+    if (err) {
+        /* Publish an empty record so the slot is reclaimed in order */
+        __atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+        fmt = NULL;
+    }
+    slot->level = level;
+    slot->fmt = fmt;
+    slot_set_seq(pos, pos + 1);
+}
+
+size_t log_isr_drain(void)
+{
+    char buffer[LOG_BUFFER_SIZE];
+    size_t count = 0;
+
+    for (;;) {
+        log_isr_slot_t* slot = &slots[tail & LOG_ISR_MASK];
+
+        if (slot_seq(tail) != tail + 1) {
+            break;
+        }
+
+        size_t length = 0;
+        int level = slot->level;
+        if (slot->fmt != NULL) {
+            length = log_format_words(buffer, sizeof(buffer), slot->fmt, slot->words);
+        }
+        slot_set_seq(tail, tail + LOG_ISR_QUEUE_LEN);
+        tail++;
+
+        if (length > 0) {
+            log_output_record(buffer, length, level);
+            count++;
+        }
+    }
+    return count;
+}
+
+int log_isr_pending(void)
+{
+    return slot_seq(tail) == tail + 1;
+}
+
+uint32_t log_isr_dropped(void)
+{
+    return __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,130 @@
+/*
+ * -----------------------------------------------------
+ *      __  __  _____  _____    _____
+ *     |  \/  ||_   _||  __ \  / ____|
+ *     | \  / |  | |  | |__) || (___
+ *     | |\/| |  | |  |  ___/  \___ \
+ *     | |  | | _| |_ | |      ____) |
+ *     |_|  |_||_____||_|     |_____/
+ * -----------------------------------------------------
+ * Copyright (c) 2025, MIPS All rights reserved.
+ * -----------------------------------------------------
+ */
+
+/**
+ * \file log_isr.h
+ * \brief Non-blocking logging for interrupt handlers.
+ *
+ * The LOG_*_ISR macros never format and never touch the UART. They copy the
+ * format string pointer and the raw argument values into a fixed slot of a
+ * lock-free queue and return. log_isr_drain(), called from thread context,
+ * formats the queued records and outputs them like log_print().
+ *
+ * %s arguments are queued by pointer, so they must still be valid when the
+ * queue is drained (string literals and static buffers are fine).
+ */
+
+#ifndef LOG_ISR_H
+#define LOG_ISR_H
+
+#include "log.h"
+#include "log_deferred.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Number of queued records. Must be a power of two. */
+#ifndef LOG_ISR_QUEUE_LEN
+#define LOG_ISR_QUEUE_LEN 16
+#endif
+
+/* Argument words per record; 64-bit arguments take two on RV32 */
+#ifndef LOG_ISR_MAX_WORDS
+#define LOG_ISR_MAX_WORDS 8
+#endif
+
+#if (LOG_ISR_QUEUE_LEN & (LOG_ISR_QUEUE_LEN - 1)) != 0
+#error "LOG_ISR_QUEUE_LEN must be a power of two"
+#endif
+
+/* Filtered by the runtime level of LOG_MODULE, like the LOG_* macros. The
+    timestamp is taken in the handler, not when the queue is drained */
+#if LOG_TIMESTAMP_MODE
+#define LOG_ISR(level, tag, fmt, ...) do { \
+    if (LOG_ENABLED(LOG_MODULE, level)) { \
+        unsigned long long log_ts_ = log_timestamp_us(); \
+        log_isr_record(level, "\n" LOG_TS_FMT "[" tag "] " fmt, LOG_ARG_TYPES(log_ts_, ##__VA_ARGS__), \
+                       log_ts_, ##__VA_ARGS__); \
+    } \
+} while (0)
+#else
+#define LOG_ISR(level, tag, fmt, ...) do { \
+    if (LOG_ENABLED(LOG_MODULE, level)) { \
+        log_isr_record(level, "\n[" tag "] " fmt, LOG_ARG_TYPES(__VA_ARGS__), ##__VA_ARGS__); \
+    } \
+} while (0)
+#endif
+
+#if LOG_MAX_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR_ISR(_fmt, ...) LOG_ISR(LOG_LEVEL_ERROR, "ERR", _fmt, ##__VA_ARGS__)
+#else
+#define LOG_ERROR_ISR(...) ((void) 0)
+#endif
+
+#if LOG_MAX_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN_ISR(_fmt, ...) LOG_ISR(LOG_LEVEL_WARN, "WAR", _fmt, ##__VA_ARGS__)
+#else
+#define LOG_WARN_ISR(...) ((void) 0)
+#endif
+
+#if LOG_MAX_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO_ISR(_fmt, ...) LOG_ISR(LOG_LEVEL_INFO, "INF", _fmt, ##__VA_ARGS__)
+#else
+#define LOG_INFO_ISR(...) ((void) 0)
+#endif
+
+#if LOG_MAX_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG_ISR(_fmt, ...) LOG_ISR(LOG_LEVEL_DEBUG, "DBG", _fmt, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG_ISR(...) ((void) 0)
+#endif
+
+/**
+ * \brief Queue a record from interrupt context.
+ *
+ * Runs in bounded time and never blocks. Normally called through the
+ * LOG_*_ISR macros.
+ *
+ * \param level LOG_LEVEL_* of the record, for the sinks.
+ * \param fmt   Format string; must stay valid until drained.
+ * \param types Argument type tags from LOG_ARG_TYPES().
+ * \param ...   Arguments.
+ */
+void log_isr_record(int level, const char* fmt, uint32_t types, ...);
+
+/**
+ * \brief Format and output all queued records.
+ *
+ * Call from thread context only, from one context at a time.
+ *
+ * \return Number of records output.
+ */
+size_t log_isr_drain(void);
+
+/**
+ * \brief Check whether records are waiting to be drained.
+ */
+int log_isr_pending(void);
+
+/**
+ * \brief Number of records dropped because the queue was full or the
+ * arguments did not fit in a slot.
+ */
+uint32_t log_isr_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* LOG_ISR_H */
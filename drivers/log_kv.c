@@ -0,0 +1,260 @@
+/*
+ * -----------------------------------------------------
+ *      __  __  _____  _____    _____
+ *     |  \/  ||_   _||  __ \  / ____|
+ *     | \  / |  | |  | |__) || (___
+ *     | |\/| |  | |  |  ___/  \___ \
+ *     | |  | | _| |_ | |      ____) |
+ *     |_|  |_||_____||_|     |_____/
+ * -----------------------------------------------------
+ * Copyright (c) 2025, MIPS All rights reserved.
+ * -----------------------------------------------------
+ */
+
+#include <string.h>
+#include "log.h"
+#include "log_kv.h"
+
+#if LOG_KV_BINARY
+
+/* CBOR major types */
+#define CBOR_UINT  0
+#define CBOR_NINT  1
+#define CBOR_TEXT  3
+#define CBOR_MAP   5
+#define CBOR_FLOAT64 0xFB
+
+// Helper function to append raw bytes to the frame
+static int append_bytes(uint8_t* frame, size_t* offset, const void* value, size_t size)
+{
+    if (*offset + size > LOG_KV_MAX_RECORD) {
+        return -1;
+    }
+    memcpy(&frame[*offset], value, size);
+    *offset += size;
+    return 0;
+}
+
+// Append a CBOR item head: major type and argument in the shortest form
+static int append_head(uint8_t* frame, size_t* offset, int major, uint64_t value)
+{
+    uint8_t bytes[9];
+    size_t size;
+
+    if (value < 24) {
+        bytes[0] = (major << 5) | value;
+        return append_bytes(frame, offset, bytes, 1);
+    } else if (value <= 0xFF) {
+        bytes[0] = (major << 5) | 24;
+        size = 1;
+    } else if (value <= 0xFFFF) {
+        bytes[0] = (major << 5) | 25;
+        size = 2;
+    } else if (value <= 0xFFFFFFFFu) {
+        bytes[0] = (major << 5) | 26;
+        size = 4;
+    } else {
+        bytes[0] = (major << 5) | 27;
+        size = 8;
+    }
+    /* CBOR is big endian */
+    for (size_t i = 0; i < size; i++) {
+        bytes[size - i] = (uint8_t)(value >> (8 * i));
+    }
+    return append_bytes(frame, offset, bytes, size + 1);
+}
+
+static int append_text(uint8_t* frame, size_t* offset, const char* str)
+{
+    if (str == NULL) {
+        /* Encoded as "", without passing NULL to memcpy() */
+        return append_head(frame, offset, CBOR_TEXT, 0);
+    }
+    size_t len = strlen(str);
+    return append_head(frame, offset, CBOR_TEXT, len) | append_bytes(frame, offset, str, len);
+}
+
+static int append_signed(uint8_t* frame, size_t* offset, int64_t value)
+{
+    /* Negative n is encoded as -1 - n */
+    return (value < 0) ? append_head(frame, offset, CBOR_NINT, ~(uint64_t)value)
+                       : append_head(frame, offset, CBOR_UINT, value);
+}
+
+static int append_value(uint8_t* frame, size_t* offset, uint32_t tag, va_list* args)
+{
+    switch (tag) {
+        case LOG_ARG_U64:
+            return append_head(frame, offset, CBOR_UINT, va_arg(*args, uint64_t));
+        case LOG_ARG_I64:
+            return append_signed(frame, offset, va_arg(*args, int64_t));
+        case LOG_ARG_I32:
+            return append_signed(frame, offset, va_arg(*args, int32_t));
+        case LOG_ARG_F64: {
+            double value = va_arg(*args, double);
+            uint64_t bits;
+            uint8_t bytes[9] = { CBOR_FLOAT64 };
+            memcpy(&bits, &value, sizeof(bits));
+            for (int i = 0; i < 8; i++) {
+                bytes[8 - i] = (uint8_t)(bits >> (8 * i));
+            }
+            return append_bytes(frame, offset, bytes, sizeof(bytes));
+        }
+        case LOG_ARG_STR:
+            return append_text(frame, offset, va_arg(*args, const char*));
+        case LOG_ARG_PTR:
+            return append_head(frame, offset, CBOR_UINT, (uintptr_t)va_arg(*args, void*));
+        case LOG_ARG_U32:
+        default:
+            return append_head(frame, offset, CBOR_UINT, va_arg(*args, uint32_t));
+    }
+}
+
+void log_kv(int level, const char* event, uint32_t types, ...)
+{
+    va_list args;
+    uint8_t frame[LOG_KV_MAX_RECORD];
+    size_t offset = 3;
+    int pairs = 2 + LOG_TIMESTAMP_MODE;
+    int err = 0;
+
+    // Fixed entries first; one map head byte holds any count up to 23
+#if LOG_TIMESTAMP_MODE
+    err |= append_text(frame, &offset, "ts");
+    err |= append_head(frame, &offset, CBOR_UINT, log_timestamp_us());
+#endif
+    err |= append_text(frame, &offset, "level");
+    err |= append_head(frame, &offset, CBOR_UINT, level);
+    err |= append_text(frame, &offset, "event");
+    err |= append_text(frame, &offset, event);
+    size_t header = offset;
+    int fixed = pairs;
+
+    va_start(args, types);
+    for (; types != LOG_ARG_END && !err; types >>= 8) {
+        err |= append_text(frame, &offset, va_arg(args, const char*));
+        err |= append_value(frame, &offset, (types >> 4) & 0xF, &args);
+        pairs++;
+    }
+    va_end(args);
+
+    if (err) {
+        /* Fields do not fit; keep the fixed entries so the event is still seen */
+        offset = header;
+        pairs = fixed;
+        log_stats_truncated();
+    }
+
+    frame[0] = LOG_KV_MAGIC;
+    frame[1] = offset - 2;
+    frame[2] = (CBOR_MAP << 5) | pairs;
+    log_output_record((const char*)frame, offset, level | LOG_RECORD_BINARY);
+}
+
+#else
+
+// Append a logfmt value, quoted and escaped when it is empty or has spaces, '=' or '"'
+static void append_quoted(char* buffer, size_t* offset, const char* str)
+{
+    if (str == NULL) {
+        str = "(null)";
+    }
+    if (*str != '\0' && strpbrk(str, " =\"\\\n") == NULL) {
+        log_append_str(buffer, offset, LOG_KV_MAX_RECORD, str, -1);
+        return;
+    }
+
+    log_append_str(buffer, offset, LOG_KV_MAX_RECORD, "\"", -1);
+    for (; *str; str++) {
+        const char* escaped = (*str == '"') ? "\\\"" : (*str == '\\') ? "\\\\" : (*str == '\n') ? "\\n" : NULL;
+        if (escaped != NULL) {
+            log_append_str(buffer, offset, LOG_KV_MAX_RECORD, escaped, -1);
+        } else {
+            log_append_str(buffer, offset, LOG_KV_MAX_RECORD, str, 1);
+        }
+    }
+    log_append_str(buffer, offset, LOG_KV_MAX_RECORD, "\"", -1);
+}
+
+#if LOG_FLOAT_MODE
+static void append_double(char* buffer, size_t* offset, const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    *offset += log_vformat(&buffer[*offset], LOG_KV_MAX_RECORD - *offset, fmt, args);
+    va_end(args);
+}
+#endif
+
+static void append_value(char* buffer, size_t* offset, uint32_t tag, va_list* args)
+{
+    switch (tag) {
+        case LOG_ARG_U64:
+            log_append_num(buffer, offset, LOG_KV_MAX_RECORD, va_arg(*args, uint64_t), 10, 0, 0, 0, 0);
+            break;
+        case LOG_ARG_I64:
+            log_append_num(buffer, offset, LOG_KV_MAX_RECORD, va_arg(*args, int64_t), 10, 1, 0, 0, 0);
+            break;
+        case LOG_ARG_I32:
+            log_append_num(buffer, offset, LOG_KV_MAX_RECORD, (int64_t)va_arg(*args, int32_t), 10, 1, 0, 0, 0);
+            break;
+        case LOG_ARG_F64: {
+            double value = va_arg(*args, double);
+#if LOG_FLOAT_MODE
+            append_double(buffer, offset, "%g", value);
+#else
+            /* No float formatting in this build; log the integer part */
+            log_append_num(buffer, offset, LOG_KV_MAX_RECORD, (int64_t)value, 10, 1, 0, 0, 0);
+#endif
+            break;
+        }
+        case LOG_ARG_STR:
+            append_quoted(buffer, offset, va_arg(*args, const char*));
+            break;
+        case LOG_ARG_PTR:
+            log_append_str(buffer, offset, LOG_KV_MAX_RECORD, "0x", -1);
+            log_append_num(buffer, offset, LOG_KV_MAX_RECORD, (uintptr_t)va_arg(*args, void*), 16, 0, 0, 0, 0);
+            break;
+        case LOG_ARG_U32:
+        default:
+            log_append_num(buffer, offset, LOG_KV_MAX_RECORD, va_arg(*args, uint32_t), 10, 0, 0, 0, 0);
+            break;
+    }
+}
+
+static const char* const level_names[] = { "log", "error", "warn", "info", "debug" };
+
+void log_kv(int level, const char* event, uint32_t types, ...)
+{
+    va_list args;
+    char buffer[LOG_KV_MAX_RECORD];
+    size_t offset = 0;
+
+#if LOG_TIMESTAMP_MODE
+    log_append_str(buffer, &offset, sizeof(buffer), "\nts=", -1);
+    log_append_num(buffer, &offset, sizeof(buffer), log_timestamp_us(), 10, 0, 0, 0, 0);
+    log_append_str(buffer, &offset, sizeof(buffer), " level=", -1);
+#else
+    log_append_str(buffer, &offset, sizeof(buffer), "\nlevel=", -1);
+#endif
+    log_append_str(buffer, &offset, sizeof(buffer),
+                   (level >= 0 && level <= LOG_LEVEL_DEBUG) ? level_names[level] : "log", -1);
+    log_append_str(buffer, &offset, sizeof(buffer), " event=", -1);
+    append_quoted(buffer, &offset, event);
+
+    va_start(args, types);
+    for (; types != LOG_ARG_END; types >>= 8) {
+        log_append_str(buffer, &offset, sizeof(buffer), " ", -1);
+        log_append_str(buffer, &offset, sizeof(buffer), va_arg(args, const char*), -1);
+        log_append_str(buffer, &offset, sizeof(buffer), "=", -1);
+        append_value(buffer, &offset, (types >> 4) & 0xF, &args);
+    }
+    va_end(args);
+
+    if (offset >= sizeof(buffer) - 1) {
+        log_stats_truncated();
+    }
+    log_output_record(buffer, offset, level);
+}
+
+#endif
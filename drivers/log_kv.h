@@ -0,0 +1,92 @@
+/*
+ * -----------------------------------------------------
+ *      __  __  _____  _____    _____
+ *     |  \/  ||_   _||  __ \  / ____|
+ *     | \  / |  | |  | |__) || (___
+ *     | |\/| |  | |  |  ___/  \___ \
+ *     | |  | | _| |_ | |      ____) |
+ *     |_|  |_||_____||_|     |_____/
+ * -----------------------------------------------------
+ * Copyright (c) 2025, MIPS All rights reserved.
+ * -----------------------------------------------------
+ */
+
+/**
+ * \file log_kv.h
+ * \brief Structured key-value log records.
+ *
+ *   LOG_KV(LOG_LEVEL_INFO, "timer", "iter", iter, "count", count);
+ *
+ * Values are typed by their C type, as for deferred logging. As text the
+ * record is logfmt:
+ *
+ *   ts=1234 level=info event=timer iter=5 count=3
+ *
+ * ts is only present with LOG_TIMESTAMP_MODE. With LOG_KV_BINARY the record
+ * is instead sent as a self-describing binary frame that needs no ELF to
+ * decode:
+ *
+ *   LOG_KV_MAGIC | length (u8) | CBOR map
+ *
+ * length counts the bytes after the length field. The map holds "ts" (if
+ * enabled), "level" and "event" followed by the fields, using the CBOR (RFC
+ * 8949) unsigned, negative, text string and double encodings, so any CBOR
+ * decoder reads it. Binary records go to the sinks flagged LOG_RECORD_BINARY.
+ * Not available in C++.
+ */
+
+#ifndef LOG_KV_H
+#define LOG_KV_H
+
+#include <stdint.h>
+#include "log.h"
+#include "log_deferred.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define LOG_KV_MAGIC 0xA9
+
+/* Send key-value records as binary frames instead of logfmt text */
+#ifndef LOG_KV_BINARY
+#define LOG_KV_BINARY LOG_DEFERRED_MODE
+#endif
+
+/* Largest record, text or binary, in bytes. The length byte limits binary
+    frames to 257 */
+#ifndef LOG_KV_MAX_RECORD
+#define LOG_KV_MAX_RECORD 128
+#endif
+
+/* Key-value pairs per record; keys and values share the eight type slots */
+#define LOG_KV_MAX_FIELDS (LOG_MAX_DEFERRED_ARGS / 2)
+
+/* Records above LOG_MAX_LEVEL fold away at compile time */
+#define LOG_KV_M(module, level, event, ...) do { \
+    _Static_assert(LOG_NARGS(__VA_ARGS__) % 2 == 0, "LOG_KV fields must be key, value pairs"); \
+    _Static_assert(LOG_NARGS(__VA_ARGS__) <= 2 * LOG_KV_MAX_FIELDS, "too many LOG_KV fields"); \
+    if ((level) <= LOG_MAX_LEVEL && LOG_ENABLED(module, level)) { \
+        log_kv(level, event, LOG_ARG_TYPES(__VA_ARGS__), ##__VA_ARGS__); \
+    } \
+} while (0)
+
+#define LOG_KV(level, event, ...) LOG_KV_M(LOG_MODULE, level, event, ##__VA_ARGS__)
+
+/**
+ * \brief Encode and output a key-value record.
+ *
+ * Normally called through LOG_KV(), never directly.
+ *
+ * \param level LOG_LEVEL_* of the record.
+ * \param event Name of the event.
+ * \param types Type tags of the alternating keys and values, from LOG_ARG_TYPES().
+ * \param ...   Keys (strings) and values.
+ */
+void log_kv(int level, const char* event, uint32_t types, ...);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* LOG_KV_H */
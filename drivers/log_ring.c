@@ -0,0 +1,231 @@
+/*
+ * -----------------------------------------------------
+ *      __  __  _____  _____    _____
+ *     |  \/  ||_   _||  __ \  / ____|
+ *     | \  / |  | |  | |__) || (___
+ *     | |\/| |  | |  |  ___/  \___ \
+ *     | |  | | _| |_ | |      ____) |
+ *     |_|  |_||_____||_|     |_____/
+ * -----------------------------------------------------
+ * Copyright (c) 2025, MIPS All rights reserved.
+ * -----------------------------------------------------
+ */
+
+#include <string.h>
+#include "log.h"
+#include "log_ring.h"
+
+/*
+ * Every record starts with an 8-byte header on an 8-byte boundary, followed
+ * by the message padded to a multiple of 8 so the next header never wraps.
+ *
+ * head and tail are free-running byte counters. A producer reserves space by
+ * advancing head with a CAS, copies its message, and commits the record by
+ * storing its inverted start position into hdr.seq with release ordering.
+ * The consumer only accepts a header whose seq matches the current tail, so
+ * neither stale headers from a previous lap nor the zeroed ring at start-up
+ * are mistaken for committed records. The tail is also advanced with a CAS
+ * because LOG_RING_POLICY_DROP_OLDEST lets producers discard records.
+ */
+
+#define LOG_RING_MASK          (LOG_RING_SIZE - 1)
+#define LOG_RING_HDR_SIZE      8u
+#define LOG_RING_RECORD_SIZE(len) (LOG_RING_HDR_SIZE + (((uint32_t)(len) + 7u) & ~7u))
+#define LOG_RING_SEQ(pos)      (~(uint32_t)(pos))
+#define LOG_RING_LEN(len)      ((len) & 0xFFFFFFu)  /* Record attributes live in the top byte */
+
+struct log_ring_hdr {
+    uint32_t seq;
+    uint32_t len;          /* Message length, attributes in bits 24-31 */
+};
+
+static struct {
+    uint32_t head;
+    uint32_t tail;
+    uint32_t dropped_bytes;
+    uint32_t dropped_records;
+    int      policy;
+    uint32_t timeout;
+    uint8_t  data[LOG_RING_SIZE] __attribute__((aligned(8)));
+} ring = {
+    .policy  = LOG_RING_POLICY,
+    .timeout = LOG_RING_BLOCK_TIMEOUT,
+};
+
+/* Consumer-side copy of the record being drained */
+static char drain_buffer[LOG_RING_MAX_RECORD];
+
+__attribute__((weak)) int log_ring_wait_hook(void)
+{
+    return 1;
+}
+
+static inline struct log_ring_hdr* ring_hdr(uint32_t pos)
+{
+    return (struct log_ring_hdr*)&ring.data[pos & LOG_RING_MASK];
+}
+
+// Copy len bytes into the ring starting at pos, wrapping at the end
+static void ring_copy_in(uint32_t pos, const char* src, size_t len)
+{
+    uint32_t start = pos & LOG_RING_MASK;
+    size_t first = LOG_RING_SIZE - start;
+
+    if (first > len) {
+        first = len;
+    }
+    memcpy(&ring.data[start], src, first);
+    memcpy(&ring.data[0], src + first, len - first);
+}
+
+// Copy len bytes out of the ring starting at pos, wrapping at the end
+static void ring_copy_out(uint32_t pos, char* dst, size_t len)
+{
+    uint32_t start = pos & LOG_RING_MASK;
+    size_t first = LOG_RING_SIZE - start;
+
+    if (first > len) {
+        first = len;
+    }
+    memcpy(dst, &ring.data[start], first);
+    memcpy(dst + first, &ring.data[0], len - first);
+}
+
+static void ring_count_drop(uint32_t length)
+{
+    __atomic_fetch_add(&ring.dropped_bytes, length, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&ring.dropped_records, 1, __ATOMIC_RELAXED);
+}
+
+/*
+ * Called by a producer that found the ring full. Returns non-zero if the
+ * producer should retry its reservation.
+ */
+static int ring_make_room(uint32_t tail, uint32_t* waited)
+{
+    switch (ring.policy) {
+        case LOG_RING_POLICY_DROP_OLDEST: {
+            struct log_ring_hdr* hdr = ring_hdr(tail);
+            if (__atomic_load_n(&ring.head, __ATOMIC_ACQUIRE) == tail) {
+                /* Drained meanwhile; the word at tail is stale, just retry */
+                return 1;
+            }
+            if (__atomic_load_n(&hdr->seq, __ATOMIC_ACQUIRE) != LOG_RING_SEQ(tail)) {
+                /* Oldest record is still being written; cannot drop it */
+                return 0;
+            }
+            uint32_t len = LOG_RING_LEN(hdr->len);
+            if (__atomic_compare_exchange_n(&ring.tail, &tail, tail + LOG_RING_RECORD_SIZE(len),
+                                            0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+                ring_count_drop(len);
+            }
+            return 1;
+        }
+        case LOG_RING_POLICY_BLOCK:
+            if (*waited >= ring.timeout) {
+                return 0;
+            }
+            (*waited)++;
+            return log_ring_wait_hook();
+        case LOG_RING_POLICY_DROP_NEWEST:
+        default:
+            return 0;
+    }
+}
+
+int log_ring_write(const char* message, size_t length, int attr)
+{
+    uint32_t need = LOG_RING_RECORD_SIZE(length);
+    uint32_t waited = 0;
+    uint32_t head;
+
+    if (length > LOG_RING_MAX_RECORD || need > LOG_RING_SIZE) {
+        ring_count_drop(length);
+        return -1;
+    }
+
+    // Reserve need bytes at head
+    for (;;) {
+        head = __atomic_load_n(&ring.head, __ATOMIC_RELAXED);
+        uint32_t tail = __atomic_load_n(&ring.tail, __ATOMIC_ACQUIRE);
+
+        if (head - tail + need > LOG_RING_SIZE) {
+            if (!ring_make_room(tail, &waited)) {
+                ring_count_drop(length);
+                return -1;
+            }
+            continue;
+        }
+        if (__atomic_compare_exchange_n(&ring.head, &head, head + need,
+                                        1, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+
+    // Fill and commit the record
+    struct log_ring_hdr* hdr = ring_hdr(head);
+    ring_copy_in(head + LOG_RING_HDR_SIZE, message, length);
+    hdr->len = length | ((uint32_t)attr << 24);
+    __atomic_store_n(&hdr->seq, LOG_RING_SEQ(head), __ATOMIC_RELEASE);
+    return 0;
+}
+
+size_t log_ring_drain(void)
+{
+    size_t total = 0;
+
+    for (;;) {
+        uint32_t tail = __atomic_load_n(&ring.tail, __ATOMIC_ACQUIRE);
+        struct log_ring_hdr* hdr = ring_hdr(tail);
+
+        if (__atomic_load_n(&ring.head, __ATOMIC_ACQUIRE) == tail) {
+            /* Empty; the word at tail is stale payload from an earlier lap */
+            break;
+        }
+        if (__atomic_load_n(&hdr->seq, __ATOMIC_ACQUIRE) != LOG_RING_SEQ(tail)) {
+            /* The oldest record is not committed yet */
+            break;
+        }
+
+        uint32_t word = hdr->len;
+        uint32_t len = LOG_RING_LEN(word);
+        int attr = word >> 24;
+        if (len > LOG_RING_MAX_RECORD) {
+            /* Header overwritten by a producer after a drop-oldest; retry */
+            continue;
+        }
+        ring_copy_out(tail + LOG_RING_HDR_SIZE, drain_buffer, len);
+
+        // Release the space before the slow output; a failed CAS means a
+        // producer dropped this record while it was being copied
+        if (!__atomic_compare_exchange_n(&ring.tail, &tail, tail + LOG_RING_RECORD_SIZE(len),
+                                         0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            continue;
+        }
+
+        log_output_direct(drain_buffer, len, attr);
+        total += len;
+    }
+    return total;
+}
+
+int log_ring_pending(void)
+{
+    return __atomic_load_n(&ring.head, __ATOMIC_ACQUIRE) != __atomic_load_n(&ring.tail, __ATOMIC_ACQUIRE);
+}
+
+void log_ring_set_policy(int policy, uint32_t timeout)
+{
+    ring.policy = policy;
+    ring.timeout = timeout;
+}
+
+uint32_t log_ring_dropped_bytes(void)
+{
+    return __atomic_load_n(&ring.dropped_bytes, __ATOMIC_RELAXED);
+}
+
+uint32_t log_ring_dropped_records(void)
+{
+    return __atomic_load_n(&ring.dropped_records, __ATOMIC_RELAXED);
+}
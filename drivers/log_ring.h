@@ -0,0 +1,119 @@
+/*
+ * -----------------------------------------------------
+ *      __  __  _____  _____    _____
+ *     |  \/  ||_   _||  __ \  / ____|
+ *     | \  / |  | |  | |__) || (___
+ *     | |\/| |  | |  |  ___/  \___ \
+ *     | |  | | _| |_ | |      ____) |
+ *     |_|  |_||_____||_|     |_____/
+ * -----------------------------------------------------
+ * Copyright (c) 2025, MIPS All rights reserved.
+ * -----------------------------------------------------
+ */
+
+/**
+ * \file log_ring.h
+ * \brief Lock-free multi-producer ring used by the asynchronous log mode.
+ */
+
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * \brief Backpressure policies applied when the ring is full.
+ */
+#define LOG_RING_POLICY_DROP_NEWEST 0 /** Discard the record being written */
+#define LOG_RING_POLICY_DROP_OLDEST 1 /** Discard committed records at the tail to make room */
+#define LOG_RING_POLICY_BLOCK       2 /** Wait for the consumer, then drop the newest record */
+
+/* Ring capacity in bytes. Must be a power of two. */
+#ifndef LOG_RING_SIZE
+#define LOG_RING_SIZE 1024
+#endif
+
+/* Largest record accepted by the ring; larger records are dropped. */
+#ifndef LOG_RING_MAX_RECORD
+#define LOG_RING_MAX_RECORD 256
+#endif
+
+#ifndef LOG_RING_POLICY
+#define LOG_RING_POLICY LOG_RING_POLICY_DROP_NEWEST
+#endif
+
+/* Number of log_ring_wait_hook() calls before a blocked writer gives up. */
+#ifndef LOG_RING_BLOCK_TIMEOUT
+#define LOG_RING_BLOCK_TIMEOUT 100
+#endif
+
+#if (LOG_RING_SIZE & (LOG_RING_SIZE - 1)) != 0
+#error "LOG_RING_SIZE must be a power of two"
+#endif
+
+/**
+ * \brief Queue a message for asynchronous output.
+ *
+ * Safe to call concurrently from any number of tasks and interrupt handlers.
+ * The message is copied; the caller never touches the UART.
+ *
+ * \param message Message bytes.
+ * \param length  Number of bytes in message.
+ * \param attr    Record attributes, handed to log_output_direct() on drain.
+ * \return 0 if queued, -1 if the record was dropped.
+ */
+int log_ring_write(const char* message, size_t length, int attr);
+
+/**
+ * \brief Write all committed records to the sinks.
+ *
+ * Only one context may drain the ring at a time.
+ *
+ * \return Number of message bytes written.
+ */
+size_t log_ring_drain(void);
+
+/**
+ * \brief Check whether committed or in-flight records are waiting.
+ */
+int log_ring_pending(void);
+
+/**
+ * \brief Select the backpressure policy at runtime.
+ *
+ * \param policy  One of LOG_RING_POLICY_*.
+ * \param timeout Wait hook calls before LOG_RING_POLICY_BLOCK gives up.
+ */
+void log_ring_set_policy(int policy, uint32_t timeout);
+
+/**
+ * \brief Total number of message bytes discarded by backpressure.
+ */
+uint32_t log_ring_dropped_bytes(void);
+
+/**
+ * \brief Total number of records discarded by backpressure.
+ */
+uint32_t log_ring_dropped_records(void);
+
+/**
+ * \brief Called by blocked writers while waiting for space.
+ *
+ * The default implementation returns immediately (busy wait). An RTOS port
+ * can override it to yield the CPU to the drain task.
+ *
+ * \return Non-zero to retry the reservation, 0 to drop the record because
+ *         the caller cannot wait, e.g. in an interrupt handler.
+ */
+int log_ring_wait_hook(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* LOG_RING_H */
@@ -0,0 +1,104 @@
+/*
+ * -----------------------------------------------------
+ *      __  __  _____  _____    _____
+ *     |  \/  ||_   _||  __ \  / ____|
+ *     | \  / |  | |  | |__) || (___
+ *     | |\/| |  | |  |  ___/  \___ \
+ *     | |  | | _| |_ | |      ____) |
+ *     |_|  |_||_____||_|     |_____/
+ * -----------------------------------------------------
+ * Copyright (c) 2025, MIPS All rights reserved.
+ * -----------------------------------------------------
+ */
+
+#include <string.h>
+#include "log_sink.h"
+
+#define SEMIHOST_SYS_OPEN  0x01
+#define SEMIHOST_SYS_WRITE 0x05
+#define SEMIHOST_OPEN_W    4 /* "w" mode */
+
+void log_ram_sink_init(log_ram_sink_t* sink, char* buffer, size_t size)
+{
+    sink->buffer = buffer;
+    sink->size = size;
+    sink->written = 0;
+}
+
+void log_ram_sink_write(void* ctx, const char* message, size_t length)
+{
+    log_ram_sink_t* sink = ctx;
+    size_t mask = sink->size - 1;
+
+    // Only the last size bytes of an oversized record survive anyway
+    if (length > sink->size) {
+        sink->written += length - sink->size;
+        message += length - sink->size;
+        length = sink->size;
+    }
+
+    size_t start = sink->written & mask;
+    size_t first = sink->size - start;
+    if (first > length) {
+        first = length;
+    }
+    memcpy(&sink->buffer[start], message, first);
+    memcpy(&sink->buffer[0], message + first, length - first);
+    sink->written += length;
+}
+
+size_t log_ram_sink_read(const log_ram_sink_t* sink, char* dst, size_t max)
+{
+    size_t mask = sink->size - 1;
+    size_t count = sink->written < sink->size ? sink->written : sink->size;
+
+    if (count > max) {
+        count = max;
+    }
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = sink->buffer[(sink->written - count + i) & mask];
+    }
+    return count;
+}
+
+#if defined(__riscv)
+// Semihosting trap; the slli/srai pair around ebreak marks it for the host
+static uintptr_t semihost_call(uintptr_t op, uintptr_t arg)
+{
+    register uintptr_t a0 __asm__("a0") = op;
+    register uintptr_t a1 __asm__("a1") = arg;
+
+    __asm__ volatile (
+        ".option push\n"
+        ".option norvc\n"
+        ".balign 16\n"
+        "slli zero, zero, 0x1f\n"
+        "ebreak\n"
+        "srai zero, zero, 7\n"
+        ".option pop\n"
+        : "+r"(a0) : "r"(a1) : "memory");
+    return a0;
+}
+#endif
+
+void log_semihost_write(void* ctx, const char* message, size_t length)
+{
+    (void)ctx;
+#if defined(__riscv)
+    static intptr_t handle = -1;
+
+    if (handle < 0) {
+        uintptr_t open_args[3] = { (uintptr_t)":tt", SEMIHOST_OPEN_W, 3 };
+        handle = (intptr_t)semihost_call(SEMIHOST_SYS_OPEN, (uintptr_t)open_args);
+        if (handle < 0) {
+            return;
+        }
+    }
+
+    uintptr_t write_args[3] = { handle, (uintptr_t)message, length };
+    semihost_call(SEMIHOST_SYS_WRITE, (uintptr_t)write_args);
+#else
+    (void)message;
+    (void)length;
+#endif
+}
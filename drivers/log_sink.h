@@ -0,0 +1,77 @@
+/*
+ * -----------------------------------------------------
+ *      __  __  _____  _____    _____
+ *     |  \/  ||_   _||  __ \  / ____|
+ *     | \  / |  | |  | |__) || (___
+ *     | |\/| |  | |  |  ___/  \___ \
+ *     | |  | | _| |_ | |      ____) |
+ *     |_|  |_||_____||_|     |_____/
+ * -----------------------------------------------------
+ * Copyright (c) 2025, MIPS All rights reserved.
+ * -----------------------------------------------------
+ */
+
+/**
+ * \file log_sink.h
+ * \brief Ready-made sinks for log_sink_add().
+ *
+ * A RAM trail that keeps the most recent output in memory, and a
+ * semihosting sink that writes to the debugger or QEMU console.
+ */
+
+#ifndef LOG_SINK_H
+#define LOG_SINK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * \brief RAM trail state; pass a pointer to it as the sink context.
+ */
+typedef struct log_ram_sink {
+    char* buffer;
+    size_t size;           /** Capacity of buffer, a power of two */
+    uint32_t written;      /** Total bytes ever written */
+} log_ram_sink_t;
+
+/**
+ * \brief Set up a RAM trail over buffer.
+ *
+ * \param sink   RAM trail state.
+ * \param buffer Storage; the oldest bytes are overwritten once it is full.
+ * \param size   Size of buffer; must be a power of two.
+ */
+void log_ram_sink_init(log_ram_sink_t* sink, char* buffer, size_t size);
+
+/**
+ * \brief Sink handler appending records to a RAM trail.
+ */
+void log_ram_sink_write(void* ctx, const char* message, size_t length);
+
+/**
+ * \brief Copy the most recent trail contents, oldest byte first.
+ *
+ * \param sink RAM trail state.
+ * \param dst  Destination buffer.
+ * \param max  Size of dst.
+ * \return Number of bytes copied.
+ */
+size_t log_ram_sink_read(const log_ram_sink_t* sink, char* dst, size_t max);
+
+/**
+ * \brief Sink handler writing records through semihosting.
+ *
+ * Only attach it when a debugger or QEMU -semihosting is present; without
+ * one the ebreak traps.
+ */
+void log_semihost_write(void* ctx, const char* message, size_t length);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* LOG_SINK_H */
@@ -0,0 +1,102 @@
+/*
+ * -----------------------------------------------------
+ *      __  __  _____  _____    _____
+ *     |  \/  ||_   _||  __ \  / ____|
+ *     | \  / |  | |  | |__) || (___
+ *     | |\/| |  | |  |  ___/  \___ \
+ *     | |  | | _| |_ | |      ____) |
+ *     |_|  |_||_____||_|     |_____/
+ * -----------------------------------------------------
+ * Copyright (c) 2025, MIPS All rights reserved.
+ * -----------------------------------------------------
+ */
+
+#include <stddef.h>
+#include "plic.h"
+
+static struct {
+    plic_handler_t handler;
+    void*          ctx;
+} handlers[PLIC_NUM_SOURCES];
+
+/* Dispatches per source; unhandled claims are counted in slot 0 */
+static uint32_t counts[PLIC_NUM_SOURCES];
+
+void plic_init(void)
+{
+    // Complete anything claimed but never completed, e.g. before a reset.
+    // The PLIC ignores completions for sources not enabled for the context,
+    // so this has to happen before the enables are cleared
+    for (uint32_t word = 0; word < (PLIC_NUM_SOURCES + 31) / 32; word++) {
+        PLIC_ENABLE(PLIC_CONTEXT, word) = 0xFFFFFFFFu;
+    }
+    for (uint32_t source = 1; source < PLIC_NUM_SOURCES; source++) {
+        PLIC_CLAIM(PLIC_CONTEXT) = source;
+    }
+
+    for (uint32_t word = 0; word < (PLIC_NUM_SOURCES + 31) / 32; word++) {
+        PLIC_ENABLE(PLIC_CONTEXT, word) = 0;
+    }
+    for (uint32_t source = 1; source < PLIC_NUM_SOURCES; source++) {
+        PLIC_PRIORITY(source) = 0;
+    }
+    PLIC_THRESHOLD(PLIC_CONTEXT) = 0;
+}
+
+int plic_register(uint32_t source, uint32_t priority, plic_handler_t handler, void* ctx)
+{
+    if (source == 0 || source >= PLIC_NUM_SOURCES || priority == 0 || priority > PLIC_MAX_PRIORITY) {
+        return -1;
+    }
+    handlers[source].ctx = ctx;
+    handlers[source].handler = handler;
+    plic_set_priority(source, priority);
+    plic_enable(source);
+    return 0;
+}
+
+void plic_set_priority(uint32_t source, uint32_t priority)
+{
+    PLIC_PRIORITY(source) = priority;
+}
+
+void plic_enable(uint32_t source)
+{
+    PLIC_ENABLE(PLIC_CONTEXT, source / 32) |= 1u << (source % 32);
+}
+
+void plic_disable(uint32_t source)
+{
+    PLIC_ENABLE(PLIC_CONTEXT, source / 32) &= ~(1u << (source % 32));
+}
+
+void plic_set_threshold(uint32_t threshold)
+{
+    PLIC_THRESHOLD(PLIC_CONTEXT) = threshold;
+}
+
+uint32_t plic_dispatch(void)
+{
+    volatile uint32_t* claim = &PLIC_CLAIM(PLIC_CONTEXT);
+    uint32_t handled = 0;
+    uint32_t source;
+
+    // Each claim returns the highest-priority pending source and clears its
+    // pending bit; 0 means nothing is left
+    while ((source = *claim) != 0) {
+        if (source < PLIC_NUM_SOURCES && handlers[source].handler != NULL) {
+            handlers[source].handler(handlers[source].ctx);
+            counts[source]++;
+        } else {
+            counts[0]++;
+        }
+        *claim = source;
+        handled++;
+    }
+    return handled;
+}
+
+uint32_t plic_dispatch_count(uint32_t source)
+{
+    return source < PLIC_NUM_SOURCES ? __atomic_load_n(&counts[source], __ATOMIC_RELAXED) : 0;
+}
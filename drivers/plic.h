@@ -0,0 +1,121 @@
+/*
+ * -----------------------------------------------------
+ *      __  __  _____  _____    _____
+ *     |  \/  ||_   _||  __ \  / ____|
+ *     | \  / |  | |  | |__) || (___
+ *     | |\/| |  | |  |  ___/  \___ \
+ *     | |  | | _| |_ | |      ____) |
+ *     |_|  |_||_____||_|     |_____/
+ * -----------------------------------------------------
+ * Copyright (c) 2025, MIPS All rights reserved.
+ * -----------------------------------------------------
+ */
+
+/**
+ * \file plic.h
+ * \brief RISC-V platform-level interrupt controller (PLIC) driver.
+ *
+ * Device interrupts are routed through the PLIC to the hart's machine
+ * external interrupt (mcause 11). The trap handler calls plic_dispatch(),
+ * which claims, handles and completes every pending source before
+ * returning, so a burst of device interrupts costs one trap entry.
+ */
+
+#ifndef PLIC_H
+#define PLIC_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* PLIC base address; QEMU virt maps it at 0x0C000000 */
+#ifndef PLIC_BASE
+#define PLIC_BASE 0x0C000000u
+#endif
+
+/* Number of interrupt sources, including the reserved source 0 */
+#ifndef PLIC_NUM_SOURCES
+#define PLIC_NUM_SOURCES 96
+#endif
+
+/* Context served by this hart: on QEMU virt, 2 * hart + 0 for M-mode */
+#ifndef PLIC_CONTEXT
+#define PLIC_CONTEXT 0
+#endif
+
+/* Highest priority the controller implements; 0 means never interrupt */
+#define PLIC_MAX_PRIORITY 7
+
+/* Register layout from the RISC-V PLIC specification */
+#define PLIC_PRIORITY(source)  (*(volatile uint32_t*)(uintptr_t)(PLIC_BASE + 4u * (source)))
+#define PLIC_PENDING(word)     (*(volatile uint32_t*)(uintptr_t)(PLIC_BASE + 0x1000u + 4u * (word)))
+#define PLIC_ENABLE(ctx, word) (*(volatile uint32_t*)(uintptr_t)(PLIC_BASE + 0x2000u + 0x80u * (ctx) + 4u * (word)))
+#define PLIC_THRESHOLD(ctx)    (*(volatile uint32_t*)(uintptr_t)(PLIC_BASE + 0x200000u + 0x1000u * (ctx)))
+#define PLIC_CLAIM(ctx)        (*(volatile uint32_t*)(uintptr_t)(PLIC_BASE + 0x200004u + 0x1000u * (ctx)))
+
+/**
+ * \brief Interrupt handler, called with the claimed source still in service.
+ */
+typedef void (*plic_handler_t)(void* ctx);
+
+/**
+ * \brief Reset the controller to a known state.
+ *
+ * Completes any claim left over from a previous run, then disables every
+ * source for PLIC_CONTEXT and sets their priorities and the threshold to 0.
+ * Call before enabling mie.MEIE.
+ */
+void plic_init(void);
+
+/**
+ * \brief Install a handler for a source and enable it.
+ *
+ * \param source   Interrupt source, 1 to PLIC_NUM_SOURCES - 1.
+ * \param priority 1 to PLIC_MAX_PRIORITY; sources at or below the threshold are masked.
+ * \param handler  Called from plic_dispatch() in interrupt context.
+ * \param ctx      Passed to handler.
+ * \return 0 on success, -1 if source or priority is out of range.
+ */
+int plic_register(uint32_t source, uint32_t priority, plic_handler_t handler, void* ctx);
+
+/**
+ * \brief Set the priority of a source.
+ */
+void plic_set_priority(uint32_t source, uint32_t priority);
+
+/**
+ * \brief Enable a source for PLIC_CONTEXT.
+ */
+void plic_enable(uint32_t source);
+
+/**
+ * \brief Disable a source for PLIC_CONTEXT.
+ */
+void plic_disable(uint32_t source);
+
+/**
+ * \brief Mask sources whose priority is at or below threshold.
+ */
+void plic_set_threshold(uint32_t threshold);
+
+/**
+ * \brief Handle all pending sources; call on a machine external interrupt.
+ *
+ * \return Number of interrupts handled in this call.
+ */
+uint32_t plic_dispatch(void);
+
+/**
+ * \brief Number of times a source has been dispatched since start-up.
+ *
+ * Source 0 counts claims of sources without a handler.
+ */
+uint32_t plic_dispatch_count(uint32_t source);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* PLIC_H */
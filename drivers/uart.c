@@ -1,19 +1,107 @@
 #include "uart.h"
+#include "uart_core.h"
 
+uart_t uart0;
 
+__attribute__((weak)) void uart_rx_hook(uart_t *uart) {
+  (void)uart;
+}
+
+// Instance API
+
+void uart_dev_init(uart_t *uart, uintptr_t base) {
+  memset(uart, 0, sizeof(*uart));
+  uart_core_init(uart, base);
+}
+
+void uart_dev_putc(uart_t *uart, char c) {
+  uart_core_putc(uart, uart->base, c);
+}
+
+void uart_dev_write(uart_t *uart, const char *str, size_t length) {
+  uart_core_write(uart, uart->base, str, length);
+}
+
+size_t uart_dev_write_nb(uart_t *uart, const char *str, size_t length) {
+  return uart_core_write_nb(uart, uart->base, str, length);
+}
+
+void uart_dev_isr(uart_t *uart) {
+  uart_core_isr(uart, uart->base);
+}
+
+void uart_dev_flush(uart_t *uart) {
+  uart_core_flush(uart, uart->base);
+}
+
+size_t uart_dev_read(uart_t *uart, char *buffer, size_t max) {
+  return uart_core_read(uart, buffer, max);
+}
+
+size_t uart_dev_tx_queued(const uart_t *uart) {
+  return uart_core_tx_queued(uart);
+}
+
+size_t uart_dev_rx_available(const uart_t *uart) {
+  return uart_core_rx_available(uart);
+}
+
+void uart_dev_stats(const uart_t *uart, uart_stats_t *stats) {
+  *stats = uart->stats;
+}
+
+// UART0. The base is a constant here, so these work before uart_init() and
+// compile to the same register accesses as a single-instance driver.
 
 void uart_putc(char c) {
-  while (!UART0_FF_THR_EMPTY);            // Wait until the FIFO holding register is empty
-  UART0_DR = c;                           // Write character to transmitter register
+  uart_core_putc(&uart0, UART0_BASE, c);
 }
 
 void uart_puts(const char *str) {
-  while (*str) {                          // Loop until value at string pointer is zero
-    uart_putc(*str++);                    // Write the character and increment pointer
-  }
+  uart_core_write(&uart0, UART0_BASE, str, strlen(str));
+}
+
+void uart_write(const char *str, size_t length) {
+  uart_core_write(&uart0, UART0_BASE, str, length);
+}
+
+unsigned long uart_lsr_reads(void) {
+  return uart0.stats.lsr_reads;
+}
+
+size_t uart_write_nb(const char *str, size_t length) {
+  return uart_core_write_nb(&uart0, UART0_BASE, str, length);
+}
+
+void uart_isr(void) {
+  uart_core_isr(&uart0, UART0_BASE);
+}
+
+void uart_flush(void) {
+  uart_core_flush(&uart0, UART0_BASE);
+}
+
+size_t uart_tx_queued(void) {
+  return uart_core_tx_queued(&uart0);
+}
+
+unsigned long uart_tx_overflows(void) {
+  return __atomic_load_n(&uart0.stats.tx_overflows, __ATOMIC_RELAXED);
+}
+
+size_t uart_read(char *buffer, size_t max) {
+  return uart_core_read(&uart0, buffer, max);
+}
+
+size_t uart_rx_available(void) {
+  return uart_core_rx_available(&uart0);
+}
+
+unsigned long uart_rx_overflows(void) {
+  return __atomic_load_n(&uart0.stats.rx_overflows, __ATOMIC_RELAXED);
 }
 
 void uart_init(void) {
-  UART0_FCR = UARTFCR_FFENA;              // Enable FIFO
+  uart_core_init(&uart0, UART0_BASE);
   // Additional initialization can be added here if needed
-}
\ No newline at end of file
+}
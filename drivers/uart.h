@@ -2,20 +2,162 @@
 #ifndef UART_H
 #define UART_H
 
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
 #define UART0_BASE 0x10000000
 
 // Use a datasheet for a 16550 UART
 // For example: https://www.ti.com/lit/ds/symlink/tl16c550d.pdf
 #define REG(base, offset) ((*((volatile unsigned char *)(base + offset))))
-#define UART0_DR    REG(UART0_BASE, 0x00)
-#define UART0_FCR   REG(UART0_BASE, 0x02)
-#define UART0_LSR   REG(UART0_BASE, 0x05)
+#define UART_DR_OFFSET  0x00
+#define UART_IER_OFFSET 0x01
+#define UART_IIR_OFFSET 0x02              // Read; FCR on write
+#define UART_FCR_OFFSET 0x02
+#define UART_MCR_OFFSET 0x04
+#define UART_LSR_OFFSET 0x05
+#define UART0_DR    REG(UART0_BASE, UART_DR_OFFSET)
+#define UART0_IER   REG(UART0_BASE, UART_IER_OFFSET)
+#define UART0_IIR   REG(UART0_BASE, UART_IIR_OFFSET)
+#define UART0_FCR   REG(UART0_BASE, UART_FCR_OFFSET)
+#define UART0_MCR   REG(UART0_BASE, UART_MCR_OFFSET)
+#define UART0_LSR   REG(UART0_BASE, UART_LSR_OFFSET)
 																						
 #define UARTFCR_FFENA 0x01                // UART FIFO Control Register enable bit
+#define UARTFCR_RXRST 0x02                // UART FIFO Control Register receive FIFO reset
+#define UARTFCR_TRIGGER_1 0x00            // Receive FIFO interrupt trigger level: 1 byte
+#define UARTFCR_TRIGGER_4 0x40            // 4 bytes
+#define UARTFCR_TRIGGER_8 0x80            // 8 bytes
+#define UARTFCR_TRIGGER_14 0xC0           // 14 bytes
+#define UARTLSR_DR 0x01                   // UART Line Status Register Data Ready bit
+#define UARTLSR_OE 0x02                   // UART Line Status Register Overrun Error bit
 #define UARTLSR_THRE 0x20                 // UART Line Status Register Transmit Hold Register Empty bit
+#define UARTIER_ERBFI 0x01                // UART Interrupt Enable Register received data available interrupt
+#define UARTIER_ETBEI 0x02                // UART Interrupt Enable Register transmit holding register empty interrupt
+#define UARTIER_ELSI 0x04                 // UART Interrupt Enable Register receiver line status interrupt
+#define UARTIIR_NO_INT 0x01               // UART Interrupt Identification Register no interrupt pending bit
+#define UARTIIR_ID_MASK 0x0E              // UART Interrupt Identification Register interrupt ID field
+#define UARTIIR_THRE 0x02                 // Interrupt ID: transmit holding register empty
+#define UARTIIR_RDA 0x04                  // Interrupt ID: receive FIFO reached the trigger level
+#define UARTIIR_RLS 0x06                  // Interrupt ID: receiver line status (overrun, parity, framing, break)
+#define UARTIIR_CTI 0x0C                  // Interrupt ID: character timeout, bytes below the trigger level went idle
+#define UARTMCR_OUT2 0x08                 // UART Modem Control Register OUT2, gates the interrupt line on PC-style boards
 #define UART0_FF_THR_EMPTY (UART0_LSR & UARTLSR_THRE)
+
+#define UART_FIFO_SIZE 16                 // Bytes the 16550 transmit FIFO takes after one THRE indication
+#define UART0_IRQ 10                      // UART0 external interrupt source on QEMU virt
+
+// Software transmit ring behind uart_write_nb(), per instance. Must be a power of two.
+#ifndef UART_TX_RING_SIZE
+#define UART_TX_RING_SIZE 1024
+#endif
+
+#if (UART_TX_RING_SIZE & (UART_TX_RING_SIZE - 1)) != 0
+#error "UART_TX_RING_SIZE must be a power of two"
+#endif
+
+// Software receive ring filled by uart_isr(), per instance. Must be a power of two.
+#ifndef UART_RX_RING_SIZE
+#define UART_RX_RING_SIZE 256
+#endif
+
+#if (UART_RX_RING_SIZE & (UART_RX_RING_SIZE - 1)) != 0
+#error "UART_RX_RING_SIZE must be a power of two"
+#endif
+
+// Count LSR reads so polled output can be measured in MMIO reads per byte;
+// see uart_stats_t.lsr_reads and uart_lsr_reads()
+#ifndef UART_MMIO_STATS
+#define UART_MMIO_STATS 0
+#endif
+
+// Receive FIFO trigger level, one of UARTFCR_TRIGGER_*. uart_isr() runs once
+// per trigger, or on a character timeout when fewer bytes arrive, instead of
+// once per byte. Higher levels mean fewer interrupts but less slack before
+// the 16-byte FIFO overruns.
+#ifndef UART_RX_TRIGGER
+#define UART_RX_TRIGGER UARTFCR_TRIGGER_8
+#endif
+
+// Per-instance counters
+typedef struct {
+  unsigned long tx_bytes;                 // Bytes written to the transmit FIFO
+  unsigned long rx_bytes;                 // Bytes read from the receive FIFO
+  unsigned long tx_overflows;             // Bytes dropped because the TX ring was full
+  unsigned long rx_overflows;             // Bytes lost to a full RX ring or a FIFO overrun
+  unsigned long interrupts;               // uart_dev_isr() calls
+  unsigned long lsr_reads;                // LSR reads, only with UART_MMIO_STATS
+} uart_stats_t;
+
+// One 16550 and its rings. In each ring head is advanced by the producer
+// and tail by the consumer; both are free-running, so head - tail is the
+// number of queued bytes.
+typedef struct uart {
+  uintptr_t base;
+  struct {
+    unsigned head;                        // Writer
+    unsigned tail;                        // Interrupt
+    char data[UART_TX_RING_SIZE];
+  } tx;
+  struct {
+    unsigned head;                        // Interrupt
+    unsigned tail;                        // Reader
+    char data[UART_RX_RING_SIZE];
+  } rx;
+  uart_stats_t stats;
+} uart_t;
+
+// Instance API; same semantics as the UART0 functions below. Any number of
+// UARTs can be driven, e.g. bulk telemetry on one and the console on
+// another. C++ code can use Uart<Base> from uart.hpp, which folds the base
+// address into the register accesses.
+void uart_dev_init(uart_t *uart, uintptr_t base);
+void uart_dev_putc(uart_t *uart, char c);
+void uart_dev_write(uart_t *uart, const char *str, size_t length);
+size_t uart_dev_write_nb(uart_t *uart, const char *str, size_t length);
+void uart_dev_isr(uart_t *uart);
+void uart_dev_flush(uart_t *uart);
+size_t uart_dev_read(uart_t *uart, char *buffer, size_t max);
+size_t uart_dev_tx_queued(const uart_t *uart);
+size_t uart_dev_rx_available(const uart_t *uart);
+void uart_dev_stats(const uart_t *uart, uart_stats_t *stats);
+
+// The console UART at UART0_BASE, behind the functions below
+extern uart_t uart0;
+
 // Function prototypes
 void uart_init(void);
 void uart_putc(char c);
 void uart_puts(const char *str) ;
+void uart_write(const char *str, size_t length); // Polled; one THRE check per FIFO's worth of bytes
+unsigned long uart_lsr_reads(void);       // LSR reads so far, 0 without UART_MMIO_STATS
+
+// Interrupt-driven transmit. uart_write_nb() copies as much of str as fits
+// into the TX ring and returns at once; uart_isr() moves it to the FIFO on
+// THRE interrupts. Writers must be serialized by the caller (one context at
+// a time, e.g. the log drain); uart_isr() is the only reader of the ring.
+// uart_putc()/uart_puts() keep polling and stay usable before interrupts
+// are set up.
+size_t uart_write_nb(const char *str, size_t length);
+void uart_isr(void);                      // Call from the UART0 external interrupt
+void uart_flush(void);                    // Poll the queued bytes out, e.g. on panic with interrupts off
+size_t uart_tx_queued(void);              // Bytes waiting in the TX ring
+unsigned long uart_tx_overflows(void);    // Bytes uart_write_nb() dropped because the ring was full
+
+// Interrupt-driven receive. uart_isr() empties the RX FIFO into the RX ring
+// and calls uart_rx_hook(&uart0); uart_read() takes bytes out of the ring without
+// touching the UART. One reader at a time.
+size_t uart_read(char *buffer, size_t max); // Returns the number of bytes copied, 0 if none
+size_t uart_rx_available(void);           // Bytes waiting in the RX ring
+unsigned long uart_rx_overflows(void);    // Bytes lost to a full RX ring or a FIFO overrun
+void uart_rx_hook(uart_t *uart);          // Weak, called from the ISR after bytes arrive; override to wake a reader
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
 #endif // UART_H
\ No newline at end of file
@@ -0,0 +1,43 @@
+// uart.hpp
+// C++ front end of the 16550 driver. Uart<Base> runs the same code as the
+// uart_dev_* functions, but with the register base as a template argument,
+// so each access compiles to an immediate offset from a constant instead
+// of a load of uart->base. Each object owns its rings and statistics.
+//
+//   static Uart<UART0_BASE> console;
+//   static Uart<0x10001000> telemetry;
+//
+//   telemetry.init();
+//   telemetry.write_nb(frame, length);   // telemetry.isr() from its PLIC source
+#ifndef UART_HPP
+#define UART_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include "uart.h"
+#include "uart_core.h"
+
+template <uintptr_t Base>
+class Uart {
+public:
+  static constexpr uintptr_t base = Base;
+
+  void init() { uart_core_init(&state_, Base); }
+  void putc(char c) { uart_core_putc(&state_, Base, c); }
+  void write(const char *str, size_t length) { uart_core_write(&state_, Base, str, length); }
+  size_t write_nb(const char *str, size_t length) { return uart_core_write_nb(&state_, Base, str, length); }
+  void isr() { uart_core_isr(&state_, Base); }
+  void flush() { uart_core_flush(&state_, Base); }
+  size_t read(char *buffer, size_t max) { return uart_core_read(&state_, buffer, max); }
+  size_t tx_queued() const { return uart_core_tx_queued(&state_); }
+  size_t rx_available() const { return uart_core_rx_available(&state_); }
+  const uart_stats_t &stats() const { return state_.stats; }
+
+  // The C view of this instance, e.g. to compare against uart_rx_hook()'s argument
+  uart_t *handle() { return &state_; }
+
+private:
+  uart_t state_{};
+};
+
+#endif // UART_HPP
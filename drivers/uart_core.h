@@ -0,0 +1,211 @@
+// uart_core.h
+// Inline core of the 16550 driver, shared by uart.c and uart.hpp. Every
+// function takes the register base separately from the instance state:
+// uart.c passes uart->base, Uart<Base> passes its template argument, and
+// the register addresses then fold into immediate offsets.
+#ifndef UART_CORE_H
+#define UART_CORE_H
+
+#include <string.h>
+#include "uart.h"
+
+// Register access; base may be a run-time value or a constant
+#ifndef UART_IO
+#define UART_IO(base, offset) (*(volatile unsigned char *)((base) + (offset)))
+#endif
+
+#define UART_TX_RING_MASK (UART_TX_RING_SIZE - 1)
+#define UART_RX_RING_MASK (UART_RX_RING_SIZE - 1)
+
+// Bytes in the receive FIFO when an RDA interrupt is raised
+#if UART_RX_TRIGGER == UARTFCR_TRIGGER_14
+#define UART_RX_TRIGGER_BYTES 14
+#elif UART_RX_TRIGGER == UARTFCR_TRIGGER_8
+#define UART_RX_TRIGGER_BYTES 8
+#elif UART_RX_TRIGGER == UARTFCR_TRIGGER_4
+#define UART_RX_TRIGGER_BYTES 4
+#else
+#define UART_RX_TRIGGER_BYTES 1
+#endif
+
+static inline unsigned char uart_core_lsr(uart_t *uart, uintptr_t base) {
+#if UART_MMIO_STATS
+  uart->stats.lsr_reads++;
+#else
+  (void)uart;
+#endif
+  return UART_IO(base, UART_LSR_OFFSET);
+}
+
+static inline void uart_core_init(uart_t *uart, uintptr_t base) {
+  uart->base = base;
+  UART_IO(base, UART_FCR_OFFSET) = UARTFCR_FFENA | UARTFCR_RXRST | UART_RX_TRIGGER; // Enable FIFO, drop stale input, set RX trigger level
+  UART_IO(base, UART_MCR_OFFSET) |= UARTMCR_OUT2; // Route the interrupt line to the interrupt controller
+  UART_IO(base, UART_IER_OFFSET) = UARTIER_ERBFI | UARTIER_ELSI; // Receive interrupts; THRE is enabled by write_nb
+}
+
+static inline void uart_core_putc(uart_t *uart, uintptr_t base, char c) {
+  while (!(uart_core_lsr(uart, base) & UARTLSR_THRE)); // Wait until the FIFO holding register is empty
+  UART_IO(base, UART_DR_OFFSET) = c;      // Write character to transmitter register
+  uart->stats.tx_bytes++;
+}
+
+static inline void uart_core_write(uart_t *uart, uintptr_t base, const char *str, size_t length) {
+  uart->stats.tx_bytes += length;
+  while (length > 0) {
+    while (!(uart_core_lsr(uart, base) & UARTLSR_THRE)); // With FIFOs on, THRE means the whole transmit FIFO is empty
+    size_t burst = length < UART_FIFO_SIZE ? length : UART_FIFO_SIZE;
+    length -= burst;
+    while (burst--) {
+      UART_IO(base, UART_DR_OFFSET) = *str++;
+    }
+  }
+}
+
+static inline size_t uart_core_tx_queued(const uart_t *uart) {
+  return __atomic_load_n(&uart->tx.head, __ATOMIC_ACQUIRE) - __atomic_load_n(&uart->tx.tail, __ATOMIC_ACQUIRE);
+}
+
+static inline size_t uart_core_rx_available(const uart_t *uart) {
+  return __atomic_load_n(&uart->rx.head, __ATOMIC_ACQUIRE) - __atomic_load_n(&uart->rx.tail, __ATOMIC_ACQUIRE);
+}
+
+static inline size_t uart_core_write_nb(uart_t *uart, uintptr_t base, const char *str, size_t length) {
+  unsigned head = uart->tx.head;
+  unsigned tail = __atomic_load_n(&uart->tx.tail, __ATOMIC_ACQUIRE);
+  size_t space = UART_TX_RING_SIZE - (head - tail);
+
+  if (length > space) {
+    __atomic_fetch_add(&uart->stats.tx_overflows, length - space, __ATOMIC_RELAXED);
+    length = space;
+  }
+  if (length == 0) {
+    return 0;
+  }
+
+  // Copy in, wrapping at the end of the ring
+  unsigned start = head & UART_TX_RING_MASK;
+  size_t first = UART_TX_RING_SIZE - start;
+  if (first > length) {
+    first = length;
+  }
+  memcpy(&uart->tx.data[start], str, first);
+  memcpy(&uart->tx.data[0], str + first, length - first);
+  __atomic_store_n(&uart->tx.head, head + length, __ATOMIC_RELEASE);
+
+  // With the holding register empty this raises THRE at once and the
+  // interrupt starts the transfer
+  UART_IO(base, UART_IER_OFFSET) |= UARTIER_ETBEI;
+  return length;
+}
+
+// Move up to one FIFO's worth of queued bytes to the UART; the caller has
+// seen THRE. Returns the number of bytes still queued.
+static inline unsigned uart_core_tx_fill(uart_t *uart, uintptr_t base) {
+  unsigned head = __atomic_load_n(&uart->tx.head, __ATOMIC_ACQUIRE);
+  unsigned tail = uart->tx.tail;
+  unsigned count = head - tail;
+
+  if (count > UART_FIFO_SIZE) {
+    count = UART_FIFO_SIZE;
+  }
+  for (unsigned i = 0; i < count; i++) {
+    UART_IO(base, UART_DR_OFFSET) = uart->tx.data[(tail + i) & UART_TX_RING_MASK];
+  }
+  __atomic_store_n(&uart->tx.tail, tail + count, __ATOMIC_RELEASE);
+  uart->stats.tx_bytes += count;
+  return head - (tail + count);
+}
+
+// Store one received byte, or count it lost if the ring is full
+static inline unsigned uart_core_rx_put(uart_t *uart, unsigned head, unsigned tail, char c) {
+  if (head - tail < UART_RX_RING_SIZE) {
+    uart->rx.data[head++ & UART_RX_RING_MASK] = c;
+  } else {
+    uart->stats.rx_overflows++;
+  }
+  return head;
+}
+
+// Empty the receive FIFO into the ring. An RDA interrupt guarantees at
+// least the trigger level in the FIFO, so that many bytes are read without
+// checking LSR first.
+static inline void uart_core_rx_drain(uart_t *uart, uintptr_t base, unsigned guaranteed) {
+  unsigned head = uart->rx.head;
+  unsigned tail = __atomic_load_n(&uart->rx.tail, __ATOMIC_ACQUIRE);
+  unsigned start = head;
+
+  while (guaranteed--) {
+    head = uart_core_rx_put(uart, head, tail, UART_IO(base, UART_DR_OFFSET));
+  }
+  while (uart_core_lsr(uart, base) & UARTLSR_DR) {
+    head = uart_core_rx_put(uart, head, tail, UART_IO(base, UART_DR_OFFSET));
+  }
+  __atomic_store_n(&uart->rx.head, head, __ATOMIC_RELEASE);
+
+  if (head != start) {
+    uart->stats.rx_bytes += head - start;
+    uart_rx_hook(uart);
+  }
+}
+
+static inline void uart_core_isr(uart_t *uart, uintptr_t base) {
+  unsigned char iir;
+
+  uart->stats.interrupts++;
+  while (!((iir = UART_IO(base, UART_IIR_OFFSET)) & UARTIIR_NO_INT)) {
+    switch (iir & UARTIIR_ID_MASK) {
+      case UARTIIR_THRE:
+        if (uart_core_tx_fill(uart, base) == 0) {
+          UART_IO(base, UART_IER_OFFSET) &= ~UARTIER_ETBEI; // Nothing left; stop THRE interrupts
+          if (uart_core_tx_queued(uart) != 0) {
+            UART_IO(base, UART_IER_OFFSET) |= UARTIER_ETBEI; // A writer queued bytes after the fill
+          }
+        }
+        break;
+      case UARTIIR_RDA:
+        uart_core_rx_drain(uart, base, UART_RX_TRIGGER_BYTES);
+        break;
+      case UARTIIR_CTI:
+        uart_core_rx_drain(uart, base, 0);
+        break;
+      case UARTIIR_RLS:
+        if (uart_core_lsr(uart, base) & UARTLSR_OE) { // Reading LSR clears the interrupt
+          uart->stats.rx_overflows++;
+        }
+        break;
+      default:
+        return;                           // Source not enabled by this driver
+    }
+  }
+}
+
+static inline void uart_core_flush(uart_t *uart, uintptr_t base) {
+  while (uart_core_tx_queued(uart) != 0) {
+    while (!(uart_core_lsr(uart, base) & UARTLSR_THRE));
+    uart_core_tx_fill(uart, base);
+  }
+}
+
+static inline size_t uart_core_read(uart_t *uart, char *buffer, size_t max) {
+  unsigned tail = uart->rx.tail;
+  unsigned head = __atomic_load_n(&uart->rx.head, __ATOMIC_ACQUIRE);
+  size_t length = head - tail;
+
+  if (length > max) {
+    length = max;
+  }
+
+  // Copy out, wrapping at the end of the ring
+  unsigned start = tail & UART_RX_RING_MASK;
+  size_t first = UART_RX_RING_SIZE - start;
+  if (first > length) {
+    first = length;
+  }
+  memcpy(buffer, &uart->rx.data[start], first);
+  memcpy(buffer + first, &uart->rx.data[0], length - first);
+  __atomic_store_n(&uart->rx.tail, tail + length, __ATOMIC_RELEASE);
+  return length;
+}
+
+#endif // UART_CORE_H
@@ -0,0 +1,165 @@
+/*
+ * -----------------------------------------------------
+ *      __  __  _____  _____    _____
+ *     |  \/  ||_   _||  __ \  / ____|
+ *     | \  / |  | |  | |__) || (___
+ *     | |\/| |  | |  |  ___/  \___ \
+ *     | |  | | _| |_ | |      ____) |
+ *     |_|  |_||_____||_|     |_____/
+ * -----------------------------------------------------
+ * Copyright (c) 2025, MIPS All rights reserved.
+ * -----------------------------------------------------
+ */
+
+#include "uart_freertos.h"
+#include "freertos_context.h"
+#include "task.h"
+#include "semphr.h"
+#include "stream_buffer.h"
+
+static StaticStreamBuffer_t tx_stream_buffer;
+static uint8_t tx_storage[UART_FREERTOS_TX_BUFFER_SIZE + 1];
+static StreamBufferHandle_t tx_stream;
+
+static StaticStreamBuffer_t rx_stream_buffer;
+static uint8_t rx_storage[UART_FREERTOS_RX_BUFFER_SIZE + 1];
+static StreamBufferHandle_t rx_stream;
+
+static StaticSemaphore_t tx_lock_buffer;
+static SemaphoreHandle_t tx_lock;
+
+static uint32_t rx_overflows;
+
+void uart_freertos_init(void)
+{
+    tx_stream = xStreamBufferCreateStatic(UART_FREERTOS_TX_BUFFER_SIZE, 1, tx_storage, &tx_stream_buffer);
+    rx_stream = xStreamBufferCreateStatic(UART_FREERTOS_RX_BUFFER_SIZE, UART_FREERTOS_RX_TRIGGER,
+                                          rx_storage, &rx_stream_buffer);
+    tx_lock = xSemaphoreCreateMutexStatic(&tx_lock_buffer);
+}
+
+// Polled fallback: send what is still queued first so output stays in order.
+// The THRE interrupt is the only other reader of tx_stream, so it is kept
+// off while this task drains the buffer; with interrupts already disabled
+// (an interrupt handler, a critical section) nothing can preempt anyway.
+static size_t uart_write_polled(const char* data, size_t length)
+{
+    char burst[UART_FIFO_SIZE];
+    size_t count;
+    int enabled = freertos_interrupts_enabled();
+    unsigned char thre;
+
+    if (enabled) {
+        taskENTER_CRITICAL();
+    }
+    thre = UART0_IER & UARTIER_ETBEI;
+    UART0_IER &= ~UARTIER_ETBEI;
+
+    while ((count = xStreamBufferReceiveFromISR(tx_stream, burst, sizeof(burst), NULL)) > 0) {
+        uart_write(burst, count);
+    }
+    uart_write(data, length);
+
+    UART0_IER |= thre;
+    if (enabled) {
+        taskEXIT_CRITICAL();
+    }
+    return length;
+}
+
+size_t uart_freertos_write(const char* data, size_t length, TickType_t timeout)
+{
+    size_t sent = 0;
+    TimeOut_t start;
+
+    if (!freertos_in_task_context()) {
+        return uart_write_polled(data, length);
+    }
+    vTaskSetTimeOutState(&start);
+    if (xSemaphoreTake(tx_lock, timeout) != pdTRUE) {
+        return 0;
+    }
+    // Charge the wait for the lock; once expired, sends no longer block
+    (void)xTaskCheckForTimeOut(&start, &timeout);
+
+    while (sent < length) {
+        size_t count = xStreamBufferSend(tx_stream, data + sent, length - sent, timeout);
+        if (count == 0) {
+            break;
+        }
+        sent += count;
+
+        // The interrupt turns THRE off once the buffer is empty; with the
+        // holding register empty, turning it on raises THRE at once
+        taskENTER_CRITICAL();
+        UART0_IER |= UARTIER_ETBEI;
+        taskEXIT_CRITICAL();
+
+        // The next send blocks only for what is left of the caller's timeout
+        if (xTaskCheckForTimeOut(&start, &timeout) != pdFALSE) {
+            break;
+        }
+    }
+
+    xSemaphoreGive(tx_lock);
+    return sent;
+}
+
+size_t uart_freertos_read(char* buffer, size_t max, TickType_t timeout)
+{
+    return xStreamBufferReceive(rx_stream, buffer, max, timeout);
+}
+
+// Empty the receive FIFO; the stream buffer notifies a blocked reader
+static void uart_freertos_rx(BaseType_t* woken)
+{
+    char burst[UART_FIFO_SIZE];
+    size_t count = 0;
+
+    while (count < sizeof(burst) && (UART0_LSR & UARTLSR_DR)) {
+        burst[count++] = UART0_DR;
+    }
+    if (xStreamBufferSendFromISR(rx_stream, burst, count, woken) != count) {
+        rx_overflows++;
+    }
+}
+
+void uart_freertos_isr(void)
+{
+    BaseType_t woken = pdFALSE;
+    unsigned char iir;
+
+    while (!((iir = UART0_IIR) & UARTIIR_NO_INT)) {
+        switch (iir & UARTIIR_ID_MASK) {
+            case UARTIIR_THRE: {
+                char burst[UART_FIFO_SIZE];
+                size_t count = xStreamBufferReceiveFromISR(tx_stream, burst, sizeof(burst), &woken);
+                if (count == 0) {
+                    UART0_IER &= ~UARTIER_ETBEI;   // Buffer empty; a writer turns THRE back on
+                }
+                for (size_t i = 0; i < count; i++) {
+                    UART0_DR = burst[i];
+                }
+                break;
+            }
+            case UARTIIR_RDA:
+            case UARTIIR_CTI:
+                uart_freertos_rx(&woken);
+                break;
+            case UARTIIR_RLS:
+                if (UART0_LSR & UARTLSR_OE) {      // Reading LSR clears the interrupt
+                    rx_overflows++;
+                }
+                break;
+            default:
+                portYIELD_FROM_ISR(woken);
+                return;
+        }
+    }
+    portYIELD_FROM_ISR(woken);
+}
+
+uint32_t uart_freertos_rx_overflows(void)
+{
+    return __atomic_load_n(&rx_overflows, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,104 @@
+/*
+ * -----------------------------------------------------
+ *      __  __  _____  _____    _____
+ *     |  \/  ||_   _||  __ \  / ____|
+ *     | \  / |  | |  | |__) || (___
+ *     | |\/| |  | |  |  ___/  \___ \
+ *     | |  | | _| |_ | |      ____) |
+ *     |_|  |_||_____||_|     |_____/
+ * -----------------------------------------------------
+ * Copyright (c) 2025, MIPS All rights reserved.
+ * -----------------------------------------------------
+ */
+
+/**
+ * \file uart_freertos.h
+ * \brief FreeRTOS UART driver on stream buffers.
+ *
+ * Writers copy into a transmit stream buffer and block while it is full;
+ * the THRE interrupt moves it to the 16-byte FIFO. The receive interrupt
+ * empties the FIFO into a receive stream buffer, and the stream buffer
+ * wakes a reader blocked in uart_freertos_read() with a direct-to-task
+ * notification. A task waiting on the UART is blocked, not spinning, so
+ * the CPU goes to other tasks meanwhile.
+ *
+ * This replaces the ring-based uart_write_nb()/uart_read() path of uart.c;
+ * route UART0_IRQ to uart_freertos_isr() instead of uart_isr().
+ */
+
+#ifndef UART_FREERTOS_H
+#define UART_FREERTOS_H
+
+#include "FreeRTOS.h"
+#include "uart.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* Size of the transmit stream buffer */
+#ifndef UART_FREERTOS_TX_BUFFER_SIZE
+#define UART_FREERTOS_TX_BUFFER_SIZE 512
+#endif
+
+/* Size of the receive stream buffer */
+#ifndef UART_FREERTOS_RX_BUFFER_SIZE
+#define UART_FREERTOS_RX_BUFFER_SIZE 128
+#endif
+
+/* Bytes that must arrive before a blocked reader is woken */
+#ifndef UART_FREERTOS_RX_TRIGGER
+#define UART_FREERTOS_RX_TRIGGER 1
+#endif
+
+#if !configUSE_STREAM_BUFFERS || !configUSE_TASK_NOTIFICATIONS || !configUSE_MUTEXES
+#error "uart_freertos.c needs configUSE_STREAM_BUFFERS, configUSE_TASK_NOTIFICATIONS and configUSE_MUTEXES"
+#endif
+
+/**
+ * \brief Create the stream buffers and the writer lock.
+ *
+ * Call after uart_init() (log_init() calls it) and before the scheduler
+ * starts, then route UART0_IRQ to uart_freertos_isr().
+ */
+void uart_freertos_init(void);
+
+/**
+ * \brief Queue bytes for transmission.
+ *
+ * Blocks while the transmit buffer is full, up to timeout ticks in total.
+ * Writers are serialized by a mutex, so a call's bytes are never
+ * interleaved with another task's. Before the scheduler runs, and with
+ * interrupts disabled (e.g. on a crash), it flushes the buffer and writes
+ * by polling instead.
+ *
+ * \return Number of bytes queued or written.
+ */
+size_t uart_freertos_write(const char* data, size_t length, TickType_t timeout);
+
+/**
+ * \brief Read received bytes.
+ *
+ * Blocks until UART_FREERTOS_RX_TRIGGER bytes are available or timeout
+ * ticks pass. Only one task may read.
+ *
+ * \return Number of bytes copied to buffer, 0 on timeout.
+ */
+size_t uart_freertos_read(char* buffer, size_t max, TickType_t timeout);
+
+/**
+ * \brief UART0 interrupt handler; call from the PLIC dispatch.
+ */
+void uart_freertos_isr(void);
+
+/**
+ * \brief Receive overflow events: a FIFO burst that did not fit in the
+ * receive buffer, or a FIFO overrun. Each event loses one or more bytes.
+ */
+uint32_t uart_freertos_rx_overflows(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* UART_FREERTOS_H */
@@ -0,0 +1,225 @@
+/*
+   Logging formatter benchmark.
+   Measures machine cycles per conversion of the log formatting kernels,
+   and log_vformat() against newlib-nano vsnprintf() for integer and float
+   conversions ("make size" compares their code size), and the MMIO status
+   reads per byte of polled UART output.
+
+   Run under QEMU with -icount so mcycle advances once per instruction
+   and the numbers are repeatable ("make run" does this).
+*/
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "log.h"
+#include "uart.h"
+
+#define BENCH_ITERATIONS 1000
+
+static char bench_buffer[64];
+
+static inline uint32_t bench_cycles(void)
+{
+    uint32_t value;
+    __asm__ volatile ("csrr %0, mcycle" : "=r" (value));
+    return value;
+}
+
+/* The formatter before the digit-pair/reciprocal kernels, kept as the baseline */
+static int append_num_baseline(char* buffer, size_t* offset, size_t max, unsigned long num, int base, int is_signed, int width, int zero_pad, int upper)
+{
+    char temp[32];
+    int i = 0;
+    unsigned long n = num;
+
+    if (is_signed && (long)num < 0) {
+        buffer[(*offset)++] = '-';
+        n = -(long)num;
+    }
+
+    do {
+        int digit = n % base;
+        temp[i++] = (digit < 10) ? '0' + digit : (upper ? 'A' : 'a') + digit - 10;
+        n /= base;
+    } while (n && i < sizeof(temp));
+
+    while (i < width && *offset < max - 1) {
+        buffer[(*offset)++] = zero_pad ? '0' : ' ';
+        width--;
+    }
+
+    while (i > 0 && *offset < max - 1) {
+        buffer[(*offset)++] = temp[--i];
+    }
+    return i;
+}
+
+static uint32_t bench_baseline(unsigned long value, int base)
+{
+    uint32_t start = bench_cycles();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        size_t offset = 0;
+        append_num_baseline(bench_buffer, &offset, sizeof(bench_buffer), value, base, 0, 0, 0, 0);
+    }
+    return (bench_cycles() - start) / BENCH_ITERATIONS;
+}
+
+static uint32_t bench_current(uint64_t value, int base)
+{
+    uint32_t start = bench_cycles();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        size_t offset = 0;
+        log_append_num(bench_buffer, &offset, sizeof(bench_buffer), value, base, 0, 0, 0, 0);
+    }
+    return (bench_cycles() - start) / BENCH_ITERATIONS;
+}
+
+static void bench_integers(void)
+{
+    static const uint64_t values[] = {
+        7u,
+        12345u,
+        4294967295u,
+        1234567890123ull,
+        18446744073709551615ull,
+    };
+
+    LOG("\nInteger conversion, cycles per call\n");
+    LOG("               value  base   before    after\n");
+
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        for (int base = 10; base <= 16; base += 6) {
+            uint64_t value = values[i];
+            if ((value >> 32) == 0) {
+                LOG("%20llu %5d %8u %8u\n", value, base,
+                    bench_baseline((unsigned long)value, base), bench_current(value, base));
+            } else {
+                /* The baseline only handled unsigned long */
+                LOG("%20llu %5d      n/a %8u\n", value, base, bench_current(value, base));
+            }
+        }
+    }
+}
+
+static char format_buffer[128];
+
+static uint32_t bench_log_vformat(const char* fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    uint32_t start = bench_cycles();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        log_vformat(format_buffer, sizeof(format_buffer), fmt, ap);
+    }
+    uint32_t cycles = (bench_cycles() - start) / BENCH_ITERATIONS;
+    va_end(ap);
+    return cycles;
+}
+
+static uint32_t bench_vsnprintf(const char* fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    uint32_t start = bench_cycles();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        va_list copy;
+        va_copy(copy, ap);
+        vsnprintf(format_buffer, sizeof(format_buffer), fmt, copy);
+        va_end(copy);
+    }
+    uint32_t cycles = (bench_cycles() - start) / BENCH_ITERATIONS;
+    va_end(ap);
+    return cycles;
+}
+
+/* Same arguments through both formatters; newlib-nano has no long long
+    support, so only int sized conversions are compared */
+#define BENCH_FORMAT(name, fmt, ...) \
+    LOG("%-10s %8u %10u\n", name, bench_log_vformat(fmt, __VA_ARGS__), bench_vsnprintf(fmt, __VA_ARGS__))
+
+static void bench_formatters(void)
+{
+    LOG("\nlog_vformat() against newlib-nano vsnprintf(), cycles per call\n");
+    LOG("case         vformat  vsnprintf\n");
+
+    BENCH_FORMAT("text", "%s", "Timer interrupt handled, rescheduling tick");
+    BENCH_FORMAT("ints", "%d %d %d %d", 1, -22, 4444, -88888888);
+    BENCH_FORMAT("hex", "reg=%08x %X", 0xdeadbeefu, 0xcafeu);
+    BENCH_FORMAT("pointer", "task=%p", (void*)format_buffer);
+    BENCH_FORMAT("padded", "[%8d] [%08u] [%4x]", 42, 7u, 0xabu);
+    BENCH_FORMAT("precision", "%.3s|%.10s", "abcdef", "short");
+}
+
+/* Cycles per float conversion; vsnprintf() gets newlib's float support
+    through -u _printf_float in the Makefile */
+static void bench_floats(void)
+{
+    LOG("\nFloat conversion, cycles per call\n");
+    LOG("case         vformat  vsnprintf\n");
+
+    BENCH_FORMAT("%f", "%f", 3.14159265358979);
+    BENCH_FORMAT("%.2f", "%.2f", -273.15);
+    BENCH_FORMAT("%e", "%e", 6.02214076e23);
+    BENCH_FORMAT("%.3e", "%.3e", 1.602176634e-19);
+    BENCH_FORMAT("%g", "%g", 0.000123456);
+    BENCH_FORMAT("%g big", "%g", 12345678.9);
+}
+
+/* LSR reads per byte written, counted by the driver with UART_MMIO_STATS.
+    uart_putc() checks THRE before every byte; uart_write() once per FIFO */
+static void bench_uart(void)
+{
+    static const char text[] = "The quick brown fox jumps over the lazy dog 0123456789\n";
+    const size_t length = sizeof(text) - 1;
+
+    unsigned long start = uart_lsr_reads();
+    for (size_t i = 0; i < length; i++) {
+        uart_putc(text[i]);
+    }
+    unsigned long putc_reads = uart_lsr_reads() - start;
+
+    start = uart_lsr_reads();
+    uart_write(text, length);
+    unsigned long write_reads = uart_lsr_reads() - start;
+
+    LOG("\nUART output, %u bytes\n", (unsigned)length);
+    LOG("case        LSR reads  per byte\n");
+    LOG("%-10s %10lu %9.2f\n", "uart_putc", putc_reads, (double)putc_reads / length);
+    LOG("%-10s %10lu %9.2f\n", "uart_write", write_reads, (double)write_reads / length);
+}
+
+/* newlib's string formatting links the reentrant allocator; give it the
+    .heap section even though a caller-supplied buffer never grows */
+extern char __heap_start[];
+extern char __heap_end[];
+
+void* _sbrk(ptrdiff_t increment)
+{
+    static char* brk = __heap_start;
+    char* previous = brk;
+
+    if (increment > __heap_end - brk) {
+        return (void*)-1;
+    }
+    brk += increment;
+    return previous;
+}
+
+int main(void)
+{
+    log_init();
+    bench_integers();
+    bench_formatters();
+    bench_floats();
+    bench_uart();
+    LOG("\nBenchmark done.\n");
+    return 0;
+}
+
+/* start.S installs a trap vector; the benchmark takes no interrupts */
+void trap_handler(void)
+{
+}
@@ -17,32 +17,81 @@
 #include "riscv_interrupts.h"
 #include "timer.h"
 #include "log.h"
+#include "log_ring.h"
+#include "log_isr.h"
+#include "log_sink.h"
+#include "plic.h"
+#include "uart.h"
 
 // Global to hold current timestamp
 static volatile uint64_t timestamp = 0;
 
 static volatile bool global_bool_keep_running = true;
 
+// Timer ticks, and how often to print the logger statistics
+static volatile uint32_t ticks = 0;
+#define LOG_STATS_INTERVAL_TICKS 10
+
+// Full-verbosity trail of recent log output, readable from the debugger
+static char log_trail_buffer[2048];
+static log_ram_sink_t log_trail;
+
+// UART0 interrupt, dispatched by the PLIC
+static void uart_irq(void* ctx) {
+    (void)ctx;
+    uart_isr();
+}
+
+// Timestamp log records with mtime instead of the default mcycle
+uint64_t log_timestamp_raw(void) {
+    return mtimer_get_raw_time();
+}
+
 int main(void) {
     log_init();
+    log_ram_sink_init(&log_trail, log_trail_buffer, sizeof(log_trail_buffer));
+    log_sink_add(log_ram_sink_write, &log_trail, LOG_LEVEL_DEBUG, LOG_SINK_TEXT | LOG_SINK_BINARY);
     LOG_INFO("Baremetal timer example started.\n");
     // Global interrupt disable
     csr_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
     csr_write_mie(0);
 
+    // Route UART0 through the PLIC
+    plic_init();
+    plic_register(UART0_IRQ, 1, uart_irq, NULL);
+
     // Setup timer for 1 second interval
     timestamp = mtimer_get_raw_time();
     mtimer_set_raw_time_cmp(MTIMER_SECONDS_TO_CLOCKS(1));
 
-    // Enable MIE.MTI
-    csr_set_bits_mie(MIE_MTI_BIT_MASK);
+    // Enable MIE.MTI and MIE.MEI
+    csr_set_bits_mie(MIE_MTI_BIT_MASK | MIE_MEI_BIT_MASK);
 
     // Global interrupt enable 
     csr_set_bits_mstatus(MSTATUS_MIE_BIT_MASK);
 
-    // Busy loop
+    // Busy loop, draining queued log records between interrupts
+    uint32_t stats_tick = 0;
     do {
-        __asm__ volatile ("wfi");  
+        log_isr_drain();
+        log_ring_drain();
+        char rx[16];
+        size_t received = uart_read(rx, sizeof(rx));
+        if (received > 0) {
+            LOG_INFO("Received %u bytes, first '%c'\n", (unsigned)received, rx[0]);
+        }
+        if (ticks - stats_tick >= LOG_STATS_INTERVAL_TICKS) {
+            stats_tick = ticks;
+            log_stats_dump();
+            LOG_INFO("UART0 interrupts: %u\n", (unsigned)plic_dispatch_count(UART0_IRQ));
+        }
+        // Check for new records with interrupts masked so one queued by an
+        // interrupt cannot slip in between the check and the wfi
+        csr_clr_bits_mstatus(MSTATUS_MIE_BIT_MASK);
+        if (!log_isr_pending() && !log_ring_pending() && uart_rx_available() == 0) {
+            __asm__ volatile ("wfi");
+        }
+        csr_set_bits_mstatus(MSTATUS_MIE_BIT_MASK);
     } while (global_bool_keep_running);
 
     // Global interrupt disable
@@ -61,10 +110,15 @@ void trap_handler(void)  {
         // Known exceptions
         switch (this_cause) {
         case RISCV_INT_POS_MTI :
-            LOG_INFO("Timer interrupt at %u\n", timestamp);
+            LOG_INFO_ISR("Timer interrupt at %llu\n", timestamp);
             // Timer exception, keep up the one second tick.
             mtimer_set_raw_time_cmp(MTIMER_SECONDS_TO_CLOCKS(1));
             timestamp = mtimer_get_raw_time();
+            ticks++;
+            break;
+        case RISCV_INT_POS_MEI :
+            // Device interrupts; drains every pending PLIC source
+            plic_dispatch();
             break;
         }
     }
@@ -40,8 +40,18 @@
 #define configTIMER_QUEUE_LENGTH 10
 #define configTIMER_TASK_STACK_DEPTH (configMINIMAL_STACK_SIZE * 2)
 
-#define configUSE_TASK_NOTIFICATIONS	0
-#define configUSE_STREAM_BUFFERS        0
+/* Logging: one thread local storage slot holds each task's log staging buffer */
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS	1
+#define configLOG_STAGING_TLS_INDEX		0
+#define configLOG_STAGING_BUFFER_SIZE	128
+#define configLOG_STAGING_POOL_SIZE		4
+#define configUSE_RECURSIVE_MUTEXES		1	/* Output lock of synchronous logging */
+
+/* UART driver: stream buffers wake blocked tasks with task notifications,
+    and a mutex serializes writers */
+#define configUSE_TASK_NOTIFICATIONS	1
+#define configUSE_STREAM_BUFFERS        1
+#define configUSE_MUTEXES				1
 
 /* Set the following definitions to 1 to include the API function, or zero
 to exclude the API function. */
@@ -12,7 +12,18 @@
 #include "FreeRTOS.h"
 #include "task.h"
 #include "timers.h"
+
+// Messages from this file are filtered by the APP module level
+#define LOG_MODULE LOG_MODULE_APP
 #include "log.h"
+#include "log_freertos.h"
+#include "log_isr.h"
+#include "log_ring.h"
+#include "log_kv.h"
+#include "plic.h"
+#include "timer.h"
+#include "uart.h"
+#include "uart_freertos.h"
 
 // Timer periods (in milliseconds)
 #define AUTO_RELOAD_PERIOD_MS  1000
@@ -26,31 +37,56 @@ static TimerHandle_t xOneShotTimer = NULL;
 // Counter for auto-reload timer iterations
 static uint32_t ulAutoReloadCount = 0;
 
+/* Timestamp log records with mtime; LOG_TIMESTAMP_HZ matches MTIME_FREQ_HZ */
+uint64_t log_timestamp_raw(void)
+{
+    return mtimer_get_raw_time();
+}
+
+/* UART0 interrupt, dispatched by the PLIC */
+static void vUartIrq(void *pvContext)
+{
+    (void)pvContext;
+    uart_freertos_isr();
+}
+
+/* Console output: the log drain task blocks on the UART instead of spinning */
+static void vLogOutput(const char *pcMessage, size_t xLength)
+{
+    uart_freertos_write(pcMessage, xLength, portMAX_DELAY);
+}
+
+/* Non-timer interrupts from the port's trap handler; mcause arrives in a0 */
+void freertos_risc_v_application_interrupt_handler(uint32_t ulMcause)
+{
+    if ((ulMcause & 0xFF) == 11)   // Machine external interrupt
+    {
+        plic_dispatch();
+    }
+}
+
 /* Auto-reload timer callback */
 void vAutoReloadTimerCallback(TimerHandle_t xTimer)
 {
     (void)xTimer;
     ulAutoReloadCount++;
 
-    // Print formatted message with timestamp (tick count)
-    LOG_INFO("[T=%d] Auto-reload timer: Iteration %d of %d\n",
-           xTaskGetTickCount() * portTICK_PERIOD_MS,
-           ulAutoReloadCount,
-           AUTO_RELOAD_MAX_COUNT);
+    // Structured record; the logger adds an mtime timestamp field
+    LOG_KV_M(LOG_MODULE_TIMER, LOG_LEVEL_INFO, "auto_reload",
+             "iter", ulAutoReloadCount,
+             "max", AUTO_RELOAD_MAX_COUNT);
 
     // Stop the timer after reaching the maximum count
     if (ulAutoReloadCount >= AUTO_RELOAD_MAX_COUNT)
     {
         if (xTimerStop(xAutoReloadTimer, 0) == pdPASS)
         {
-            LOG_INFO("[T=%d] Auto-reload timer: Stopped after %d iterations\n",
-                   xTaskGetTickCount() * portTICK_PERIOD_MS,
+            LOG_INFO_M(LOG_MODULE_TIMER, "Auto-reload timer: Stopped after %d iterations\n",
                    AUTO_RELOAD_MAX_COUNT);
         }
         else
         {
-            LOG_INFO("[T=%d] Auto-reload timer: Error stopping timer\n",
-                   xTaskGetTickCount() * portTICK_PERIOD_MS);
+            LOG_INFO_M(LOG_MODULE_TIMER, "Auto-reload timer: Error stopping timer\n");
         }
     }
 }
@@ -59,9 +95,7 @@ void vAutoReloadTimerCallback(TimerHandle_t xTimer)
 void vOneShotTimerCallback(TimerHandle_t xTimer)
 {
     (void)xTimer;
-    // Print formatted message with timestamp
-    LOG_INFO("[T=%d] One-shot timer: Triggered single event\n",
-           xTaskGetTickCount() * portTICK_PERIOD_MS);
+    LOG_INFO_M(LOG_MODULE_TIMER, "One-shot timer: Triggered single event\n");
 }
 
 /* Main task to initialize and start timers */
@@ -114,10 +148,10 @@ void vMainTask(void *pvParameters)
         for(;;); // Halt on error
     }
 
-    LOG_INFO("[T=%d] Timers started successfully\n",
-           xTaskGetTickCount() * portTICK_PERIOD_MS);
+    LOG_INFO("Timers started successfully\n");
 
-    // Task is no longer needed, delete itself
+    // Task is no longer needed, hand back its log buffer and delete itself
+    log_task_release();
     vTaskDelete(NULL);
 }
 
@@ -125,6 +159,12 @@ void vMainTask(void *pvParameters)
 void main(void)
 {
     log_init();
+    log_freertos_init();
+    // The port enables mie.MEIE when the scheduler starts
+    uart_freertos_init();
+    log_register_output_handler(vLogOutput);
+    plic_init();
+    plic_register(UART0_IRQ, 1, vUartIrq, NULL);
     // Create the main task
     BaseType_t xResult = xTaskCreate(
         vMainTask,          // Task function
@@ -149,6 +189,26 @@ void main(void)
 }
 
 
+/* Panic output. Interrupts are off and the drain task will not run again, so
+ * what is queued is written out first and the message itself bypasses the
+ * ring; with MIE clear, uart_freertos_write() polls the UART. */
+static void vPanicPrint( const char * pcFormat, ... )
+{
+    char cBuffer[LOG_BUFFER_SIZE];
+    va_list xArgs;
+    size_t xLength;
+
+#if LOG_ASYNC_MODE
+    log_isr_drain();
+    log_ring_drain();
+#endif
+    va_start( xArgs, pcFormat );
+    xLength = log_vformat( cBuffer, sizeof( cBuffer ), pcFormat, xArgs );
+    va_end( xArgs );
+    log_output_direct( cBuffer, xLength, LOG_LEVEL_ERROR );
+}
+
+
 void vAssertCalled( const char * pcFileName,
                     uint32_t ulLine )
 {
@@ -157,10 +217,10 @@ void vAssertCalled( const char * pcFileName,
     /* Called if an assertion passed to configASSERT() fails.  See
      * http://www.freertos.org/a00110.html#configASSERT for more information. */
 
-    LOG_INFO("ASSERT! Line %d, file %s\r\n", ( int ) ulLine, pcFileName );
-
     taskENTER_CRITICAL();
     {
+        vPanicPrint( "\nASSERT! Line %d, file %s\r\n", ( int ) ulLine, pcFileName );
+
         /* You can step out of this function to debug the assertion by using
          * the debugger to set ulSetToNonZeroInDebuggerToContinue to a non-zero
          * value. */
@@ -183,8 +243,8 @@ void vApplicationStackOverflowHook( TaskHandle_t pxTask,
     /* Run time stack overflow checking is performed if
      * configCHECK_FOR_STACK_OVERFLOW is defined to 1 or 2.  This hook
      * function is called if a stack overflow is detected. */
-    LOG_INFO("\r\n\r\nStack overflow in %s\r\n", pcTaskName );
     portDISABLE_INTERRUPTS();
+    vPanicPrint( "\r\n\r\nStack overflow in %s\r\n", pcTaskName );
 
     for( ; ; )
     {
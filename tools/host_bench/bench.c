@@ -0,0 +1,237 @@
+/*
+   Host benchmark of the log formatter.
+   Runs log_print() and log_vformat() natively over representative format
+   strings, reports ns/message and output bytes/s, and diffs every record
+   against snprintf().
+
+   Usage: host_bench [iterations]
+   Exit status is non-zero if any record differs from snprintf().
+*/
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "log.h"
+
+/* Longest record of any case; log_print() writes longer ones in chunks */
+#define BENCH_RECORD_MAX 1024
+
+static char capture[BENCH_RECORD_MAX];
+static size_t capture_length;
+static uint64_t capture_bytes;
+
+static long iterations = 1000000;
+static int failures;
+
+/* Console handler: collect the chunks of the current record and count the output bytes */
+static void bench_output(const char* message, size_t length)
+{
+    if (capture_length + length <= sizeof(capture)) {
+        memcpy(&capture[capture_length], message, length);
+        capture_length += length;
+    }
+    capture_bytes += length;
+}
+
+static uint64_t bench_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/* Compare the captured record with what snprintf() made of the same call */
+static void bench_check(const char* name, const char* expected)
+{
+    size_t length = strlen(expected);
+
+    if (length != capture_length || memcmp(expected, capture, length) != 0) {
+        printf("FAIL %-12s\n  expected: \"%s\"\n  got:      \"%.*s\"\n",
+               name, expected, (int)capture_length, capture);
+        failures++;
+    }
+}
+
+static void bench_report(const char* name, uint64_t log_ns, uint64_t bytes, uint64_t libc_ns)
+{
+    double ns_per_msg = (double)log_ns / iterations;
+    double mb_per_s = log_ns ? (double)bytes * 1000.0 / log_ns : 0.0;
+    double libc_per_msg = (double)libc_ns / iterations;
+
+    printf("%-12s %10.1f %10.1f %12.1f %8.2fx\n",
+           name, ns_per_msg, mb_per_s, libc_per_msg,
+           ns_per_msg > 0.0 ? libc_per_msg / ns_per_msg : 0.0);
+}
+
+/*
+ * Check one format against snprintf(), then time log_print() and, for
+ * reference, snprintf() into a buffer large enough for the whole record.
+ */
+#define BENCH_CASE(name, fmt, ...) do { \
+    char expected_[BENCH_RECORD_MAX]; \
+    char scratch_[BENCH_RECORD_MAX]; \
+    snprintf(expected_, sizeof(expected_), fmt, ##__VA_ARGS__); \
+    capture_length = 0; \
+    log_print(fmt, ##__VA_ARGS__); \
+    bench_check(name, expected_); \
+    capture_bytes = 0; \
+    uint64_t start_ = bench_ns(); \
+    for (long i_ = 0; i_ < iterations; i_++) { \
+        capture_length = 0; \
+        log_print(fmt, ##__VA_ARGS__); \
+    } \
+    uint64_t log_ns_ = bench_ns() - start_; \
+    uint64_t bytes_ = capture_bytes; \
+    start_ = bench_ns(); \
+    for (long i_ = 0; i_ < iterations; i_++) { \
+        snprintf(scratch_, sizeof(scratch_), fmt, ##__VA_ARGS__); \
+        __asm__ volatile ("" : : "r"(scratch_) : "memory"); \
+    } \
+    bench_report(name, log_ns_, bytes_, bench_ns() - start_); \
+} while (0)
+
+/* Time one call of a formatting kernel; there is no snprintf() reference */
+#define BENCH_KERNEL(name, call) do { \
+    char buffer_[32]; \
+    uint64_t bytes_ = 0; \
+    uint64_t start_ = bench_ns(); \
+    for (long i_ = 0; i_ < iterations; i_++) { \
+        size_t offset_ = 0; \
+        call; \
+        __asm__ volatile ("" : : "r"(buffer_) : "memory"); \
+        bytes_ += offset_; \
+    } \
+    uint64_t ns_ = bench_ns() - start_; \
+    printf("%-12s %10.1f %10.1f\n", name, (double)ns_ / iterations, \
+           ns_ ? (double)bytes_ * 1000.0 / ns_ : 0.0); \
+} while (0)
+
+static void bench_formats(void)
+{
+    static const char long_text[] =
+        "the quick brown fox jumps over the lazy dog; the quick brown fox jumps over the lazy dog; "
+        "the quick brown fox jumps over the lazy dog";
+    int local = 0;
+
+    printf("%-12s %10s %10s %12s %9s\n", "case", "ns/msg", "MB/s", "snprintf ns", "speedup");
+
+    BENCH_CASE("plain", "\n[INFO] Timer interrupt handled, rescheduling tick");
+    BENCH_CASE("string", "\n[INFO] %s: %s", "uart", "initialised at 115200 baud");
+    BENCH_CASE("int", "\n[INFO] count=%d", 12345);
+    BENCH_CASE("many-ints", "\n[DEBUG] %d %d %d %d %d %d %d %d", 1, -22, 333, -4444, 55555, -666666, 7777777, -88888888);
+    BENCH_CASE("unsigned", "\n[INFO] %u %lu %llu", 4294967295u, 123456789ul, 18446744073709551615ull);
+    BENCH_CASE("negative64", "\n[WARN] delta=%lld", -9223372036854775807ll);
+    BENCH_CASE("hex", "\n[DEBUG] reg=%x %X %08x", 0xdeadbeefu, 0xcafef00du, 0x1234u);
+    BENCH_CASE("hex64", "\n[DEBUG] addr=%llx", 0x0123456789abcdefull);
+    BENCH_CASE("pointer", "\n[DEBUG] task=%p", (void*)&local);
+    BENCH_CASE("padded", "\n[INFO] [%8d] [%08u] [%4x] [%010lld]", 42, 7u, 0xabu, -123456ll);
+    BENCH_CASE("precision", "\n[INFO] %.3s|%.10s|%.0s|", "abcdef", "short", "hidden");
+    BENCH_CASE("short", "\n[INFO] %hhx %hu %hhd %hd %hhu %04hX", 0x1ff, 70000, 200, -70000, 300, 0x12345);
+    BENCH_CASE("char", "\n[INFO] %c%c%c 100%%", 'a', 'b', 'c');
+    BENCH_CASE("mixed", "\n[ERROR] %s:%d: status=%08x len=%u ptr=%p", "uart.c", 118, 0x80000001u, 64u, (void*)&local);
+    BENCH_CASE("long", "\n[INFO] %s %s", long_text, long_text);
+    BENCH_CASE("hexdump", "\n[DEBUG] 0000: %08x %08x %08x %08x %08x %08x %08x %08x"
+               "\n[DEBUG] 0020: %08x %08x %08x %08x %08x %08x %08x %08x",
+               0x00010203u, 0x04050607u, 0x08090a0bu, 0x0c0d0e0fu, 0x10111213u, 0x14151617u, 0x18191a1bu, 0x1c1d1e1fu,
+               0x20212223u, 0x24252627u, 0x28292a2bu, 0x2c2d2e2fu, 0x30313233u, 0x34353637u, 0x38393a3bu, 0x3c3d3e3fu);
+    BENCH_CASE("float-f", "\n[INFO] t=%f v=%.2f", 3.14159265358979, -273.15);
+    BENCH_CASE("float-e", "\n[INFO] n=%e q=%.3E", 6.02214076e23, 1.602176634e-19);
+    BENCH_CASE("float-g", "\n[INFO] %g %g %.10g", 0.000123456, 12345678.9, 1.0 / 3.0);
+    BENCH_CASE("float-tie", "\n[INFO] %.1f %.2f %.0f %.0f %.2e %.3g", -0.05, 2.675, 0.5, 2.5, 1.125, 1.0005);
+    BENCH_CASE("wide-pad", "\n[INFO] [%300d] [%0300lld]", 42, -7ll);
+}
+
+static uint64_t bench_vformat_ns(int use_libc, char* buffer, size_t max, const char* fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    uint64_t start = bench_ns();
+    for (long i = 0; i < iterations; i++) {
+        va_list copy;
+        va_copy(copy, ap);
+        if (use_libc) {
+            vsnprintf(buffer, max, fmt, copy);
+        } else {
+            log_vformat(buffer, max, fmt, copy);
+        }
+        va_end(copy);
+        __asm__ volatile ("" : : "r"(buffer) : "memory");
+    }
+    uint64_t ns = bench_ns() - start;
+    va_end(ap);
+    return ns;
+}
+
+/*
+ * log_vformat() into a caller buffer, no sinks involved: check against
+ * vsnprintf() with the same buffer size, then time both.
+ */
+#define BENCH_VFORMAT(name, fmt, ...) do { \
+    char expected_[LOG_BUFFER_SIZE]; \
+    char buffer_[LOG_BUFFER_SIZE]; \
+    snprintf(expected_, sizeof(expected_), fmt, ##__VA_ARGS__); \
+    bench_vformat_ns(0, capture, sizeof(buffer_), fmt, ##__VA_ARGS__); \
+    capture_length = strlen(capture); \
+    bench_check(name, expected_); \
+    uint64_t log_ns_ = bench_vformat_ns(0, buffer_, sizeof(buffer_), fmt, ##__VA_ARGS__); \
+    uint64_t libc_ns_ = bench_vformat_ns(1, buffer_, sizeof(buffer_), fmt, ##__VA_ARGS__); \
+    bench_report(name, log_ns_, (uint64_t)strlen(expected_) * iterations, libc_ns_); \
+} while (0)
+
+static void bench_vformat(void)
+{
+    int local = 0;
+
+    printf("\n%-12s %10s %10s %12s %9s\n", "log_vformat", "ns/call", "MB/s", "vsnprintf ns", "speedup");
+
+    BENCH_VFORMAT("v-text", "%s", "Timer interrupt handled, rescheduling tick");
+    BENCH_VFORMAT("v-ints", "%d %d %d %d", 1, -22, 4444, -88888888);
+    BENCH_VFORMAT("v-hex", "reg=%08x %X", 0xdeadbeefu, 0xcafeu);
+    BENCH_VFORMAT("v-pointer", "task=%p", (void*)&local);
+    BENCH_VFORMAT("v-padded", "[%8d] [%08u] [%4x]", 42, 7u, 0xabu);
+    BENCH_VFORMAT("v-precision", "%.3s|%.10s", "abcdef", "short");
+    BENCH_VFORMAT("v-float-f", "%f", 3.14159265358979);
+    BENCH_VFORMAT("v-float-e", "%e", 6.02214076e23);
+    BENCH_VFORMAT("v-float-g", "%g", 0.000123456);
+}
+
+static void bench_kernels(void)
+{
+    printf("\n%-12s %10s %10s\n", "kernel", "ns/call", "MB/s");
+
+    BENCH_KERNEL("num-dec32", log_append_num(buffer_, &offset_, sizeof(buffer_), 4294967295u, 10, 0, 0, 0, 0));
+    BENCH_KERNEL("num-dec64", log_append_num(buffer_, &offset_, sizeof(buffer_), 18446744073709551615ull, 10, 0, 0, 0, 0));
+    BENCH_KERNEL("num-signed", log_append_num(buffer_, &offset_, sizeof(buffer_), (uint64_t)-12345ll, 10, 1, 0, 0, 0));
+    BENCH_KERNEL("num-hex", log_append_num(buffer_, &offset_, sizeof(buffer_), 0xdeadbeefu, 16, 0, 8, 1, 0));
+    BENCH_KERNEL("str", log_append_str(buffer_, &offset_, sizeof(buffer_), "initialised", -1));
+    BENCH_KERNEL("str-prec", log_append_str(buffer_, &offset_, sizeof(buffer_), "initialised", 4));
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1) {
+        iterations = strtol(argv[1], NULL, 0);
+        if (iterations <= 0) {
+            fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    log_register_output_handler(bench_output);
+
+    printf("log formatter, %ld messages per case, %d byte chunks\n\n", iterations, LOG_BUFFER_SIZE);
+    bench_formats();
+    bench_vformat();
+    bench_kernels();
+
+    if (failures) {
+        printf("\n%d case(s) differ from snprintf\n", failures);
+        return 1;
+    }
+    printf("\nall cases match snprintf\n");
+    return 0;
+}
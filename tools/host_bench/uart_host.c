@@ -0,0 +1,27 @@
+/*
+   Host stand-in for the 16550 driver.
+   Implements the uart.h API on stdout so drivers/log.c links natively.
+*/
+
+#include <stdio.h>
+
+#include "uart.h"
+
+void uart_init(void)
+{
+}
+
+void uart_putc(char c)
+{
+    putchar(c);
+}
+
+void uart_puts(const char *str)
+{
+    fputs(str, stdout);
+}
+
+void uart_write(const char *str, size_t length)
+{
+    fwrite(str, 1, length, stdout);
+}
@@ -0,0 +1,345 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2025, MIPS All rights reserved.
+#
+"""Render deferred log frames (LOG_DEFERRED_MODE) as text.
+
+Reads the interned format strings from the .logstr section of the firmware
+ELF, then decodes the UART byte stream from stdin (or a capture file).
+Bytes outside of frames are passed through as UTF-8 text; a magic byte only
+starts a frame when what follows it decodes exactly to the announced length. Both the fixed-size
+and the compact (LOG_DEFERRED_COMPACT) frame layouts are understood, as are
+the self-describing key-value frames of log_kv.h, which are printed as logfmt.
+
+    qemu-system-riscv32 ... | python3 log_decode.py build/hello_freertos.elf
+"""
+
+import argparse
+import codecs
+import re
+import struct
+import sys
+
+LOG_DEFERRED_MAGIC = 0xA5
+LOG_DEFERRED_MAGIC_TS = 0xA6
+LOG_DEFERRED_MAGIC_C = 0xA7
+LOG_DEFERRED_MAGIC_CTS = 0xA8
+LOG_KV_MAGIC = 0xA9
+MAGICS = (LOG_DEFERRED_MAGIC, LOG_DEFERRED_MAGIC_TS, LOG_DEFERRED_MAGIC_C, LOG_DEFERRED_MAGIC_CTS, LOG_KV_MAGIC)
+
+LEVEL_NAMES = ("log", "error", "warn", "info", "debug")
+
+LOG_ARG_U32 = 1
+LOG_ARG_U64 = 2
+LOG_ARG_F64 = 3
+LOG_ARG_STR = 4
+LOG_ARG_PTR = 5
+LOG_ARG_I32 = 6
+LOG_ARG_I64 = 7
+
+FORMAT_SPEC = re.compile(r"%([-+ #0]*)(\d*)(?:\.(\d+))?(hh|h|ll|l|z|j|t)?([diuxXcspfeEgG%])")
+
+
+def read_logstr(path):
+    """Return the raw contents of the .logstr section."""
+    with open(path, "rb") as f:
+        elf = f.read()
+    if elf[:4] != b"\x7fELF":
+        raise SystemExit(f"{path}: not an ELF file")
+    is64 = elf[4] == 2
+    endian = "<" if elf[5] == 1 else ">"
+    if is64:
+        shoff, = struct.unpack_from(endian + "Q", elf, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + "HHH", elf, 0x3A)
+        sh_fmt = endian + "IIQQQQIIQQ"
+    else:
+        shoff, = struct.unpack_from(endian + "I", elf, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + "HHH", elf, 0x2E)
+        sh_fmt = endian + "IIIIIIIIII"
+
+    sections = [struct.unpack_from(sh_fmt, elf, shoff + i * shentsize) for i in range(shnum)]
+    names = sections[shstrndx]
+    for sh in sections:
+        name_off = names[4] + sh[0]
+        name = elf[name_off:elf.index(b"\0", name_off)].decode()
+        if name == ".logstr":
+            return elf[sh[4]:sh[4] + sh[5]], sh[3]
+    # Key-value frames decode without it; deferred frames will fail
+    return None, 0
+
+
+class CallSite:
+    def __init__(self, table, base, offset):
+        pos = offset - base
+        self.types, self.line = struct.unpack_from("<II", table, pos)
+        fields = table[pos + 8:].split(b"\0", 3)
+        self.level, self.file, self.fmt = (x.decode(errors="replace") for x in fields[:3])
+
+
+def read_varint(data, pos):
+    """Decode an unsigned LEB128 value; returns (value, next position)."""
+    value = shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, pos
+
+
+def decode_args(types, payload, pos=0):
+    """Decode fixed-size arguments; returns (arguments, next position).
+
+    Integers are kept as raw bit patterns.
+    """
+    args = []
+    while types:
+        tag = types & 0xF
+        types >>= 4
+        if tag in (LOG_ARG_U64, LOG_ARG_I64):
+            args.append(("u64", struct.unpack_from("<Q", payload, pos)[0]))
+            pos += 8
+        elif tag == LOG_ARG_F64:
+            args.append(("f64", struct.unpack_from("<d", payload, pos)[0]))
+            pos += 8
+        elif tag == LOG_ARG_STR:
+            n = payload[pos]
+            args.append(("str", payload[pos + 1:pos + 1 + n].decode(errors="replace")))
+            pos += 1 + n
+        else:
+            args.append(("u32", struct.unpack_from("<I", payload, pos)[0]))
+            pos += 4
+    if pos > len(payload):
+        raise IndexError("frame truncated")
+    return args, pos
+
+
+def decode_args_compact(types, payload, pos=0):
+    """Decode varint arguments of a compact frame, like decode_args()."""
+    args = []
+    while types:
+        tag = types & 0xF
+        types >>= 4
+        if tag == LOG_ARG_F64:
+            args.append(("f64", struct.unpack_from("<d", payload, pos)[0]))
+            pos += 8
+            continue
+        value, pos = read_varint(payload, pos)
+        if tag == LOG_ARG_STR:
+            args.append(("str", payload[pos:pos + value].decode(errors="replace")))
+            pos += value
+        elif tag in (LOG_ARG_I32, LOG_ARG_I64):
+            bits = 64 if tag == LOG_ARG_I64 else 32
+            value = (value >> 1) ^ -(value & 1)
+            args.append(("u64" if bits == 64 else "u32", value & ((1 << bits) - 1)))
+        else:
+            args.append(("u64" if tag == LOG_ARG_U64 else "u32", value))
+    if pos > len(payload):
+        raise IndexError("frame truncated")
+    return args, pos
+
+
+def read_cbor(data, pos):
+    """Decode the CBOR subset log_kv.c emits; returns (value, next position)."""
+    initial = data[pos]
+    pos += 1
+    if initial == 0xFB:
+        return struct.unpack_from(">d", data, pos)[0], pos + 8
+    major, info = initial >> 5, initial & 0x1F
+    if info < 24:
+        arg = info
+    elif info <= 27:
+        size = 1 << (info - 24)
+        arg = int.from_bytes(data[pos:pos + size], "big")
+        pos += size
+    else:
+        raise ValueError(f"unsupported CBOR item 0x{initial:02x}")
+    if major == 0:
+        return arg, pos
+    if major == 1:
+        return -1 - arg, pos
+    if major in (2, 3):
+        if pos + arg > len(data):
+            raise IndexError("frame truncated")
+        raw = data[pos:pos + arg]
+        return (raw.decode(errors="replace") if major == 3 else raw), pos + arg
+    if major == 5:
+        items = {}
+        for _ in range(arg):
+            key, pos = read_cbor(data, pos)
+            items[key], pos = read_cbor(data, pos)
+        return items, pos
+    raise ValueError(f"unsupported CBOR major type {major}")
+
+
+def logfmt_value(value):
+    """Render a value the way log_kv.c does in text mode."""
+    if isinstance(value, float):
+        return format(value, "g")
+    value = str(value)
+    if value and not any(c in value for c in ' ="\\\n'):
+        return value
+    return '"' + value.replace("\\", "\\\\").replace('"', '\\"').replace("\n", "\\n") + '"'
+
+
+def render_kv(body):
+    """Render a key-value frame body as a logfmt line."""
+    items, pos = read_cbor(body, 0)
+    if pos != len(body) or not isinstance(items, dict):
+        raise ValueError("not a key-value frame")
+    level = items.get("level")
+    if isinstance(level, int) and 0 <= level < len(LEVEL_NAMES):
+        items["level"] = LEVEL_NAMES[level]
+    return " ".join(f"{key}={logfmt_value(value)}" for key, value in items.items())
+
+
+def render(fmt, args):
+    """Format like the target's log_print()."""
+    args = iter(args)
+
+    def one(m):
+        flags, width, prec, mod, conv = m.groups()
+        if conv == "%":
+            return "%"
+        kind, value = next(args, ("u32", 0))
+        if conv == "p":
+            return "0x" + format(value, "0" + (width or "") + "x")
+        if conv == "s":
+            return value if prec is None else value[:int(prec)]
+        if conv == "c":
+            return chr(value & 0xFF)
+        if conv in "diouxX":
+            bits = {"hh": 8, "h": 16}.get(mod, 64 if kind == "u64" else 32)
+            value &= (1 << bits) - 1
+            if conv in "di" and value >= 1 << (bits - 1):
+                value -= 1 << bits
+        spec = "%" + flags + width + ("." + prec if prec is not None else "")
+        return (spec + ("d" if conv == "u" else conv)) % value
+
+    return FORMAT_SPEC.sub(one, fmt)
+
+
+class FrameDecoder:
+    """Validate and render the frames of one capture."""
+
+    def __init__(self, table, base, opts):
+        self.table, self.base, self.opts = table, base, opts
+        self.sites = {}
+        self.ticks = 0
+
+    def site(self, string_id):
+        """Return the call site at string_id, or None if it is not a .logstr entry."""
+        if self.table is None or string_id % 4 or not 0 <= string_id - self.base <= len(self.table) - 8:
+            return None
+        site = self.sites.get(string_id)
+        if site is None:
+            try:
+                site = self.sites[string_id] = CallSite(self.table, self.base, string_id)
+            except (struct.error, ValueError):
+                return None
+        return site
+
+    def text(self, magic, body):
+        """Return the text of a frame, or None if body is not a well-formed frame."""
+        if magic == LOG_KV_MAGIC:
+            try:
+                return "\n" + render_kv(body)
+            except (struct.error, IndexError, TypeError, ValueError):
+                return None
+        compact = magic in (LOG_DEFERRED_MAGIC_C, LOG_DEFERRED_MAGIC_CTS)
+        try:
+            if compact:
+                string_id, pos = read_varint(body, 0)
+                string_id *= 4
+            else:
+                string_id, = struct.unpack_from("<I", body)
+                pos = 4
+            delta = 0
+            if magic in (LOG_DEFERRED_MAGIC_TS, LOG_DEFERRED_MAGIC_CTS):
+                delta, pos = read_varint(body, pos)
+        except (struct.error, IndexError):
+            return None
+        site = self.site(string_id)
+        if site is None or pos > len(body):
+            return None
+        try:
+            decode = decode_args_compact if compact else decode_args
+            args, end = decode(site.types, body, pos)
+        except (struct.error, IndexError):
+            args, end = None, pos
+        if end != len(body):
+            return None
+        if args is None:
+            # The target drops all arguments when they do not fit the frame
+            text = site.fmt + " <truncated>"
+        else:
+            try:
+                text = render(site.fmt, args)
+            except (TypeError, ValueError):
+                text = site.fmt + " <bad arguments: " + ", ".join(str(value) for _, value in args) + ">"
+
+        prefix = "\n"
+        if magic in (LOG_DEFERRED_MAGIC_TS, LOG_DEFERRED_MAGIC_CTS):
+            self.ticks += delta
+            prefix += f"[{self.ticks * 1000000 // self.opts.hz:10d}] "
+        prefix += f"[{site.level}] "
+        if self.opts.verbose:
+            prefix += f"{site.file}:{site.line} - "
+        return prefix + text
+
+
+class ByteSource:
+    """Read bytes with push-back, so a rejected frame can be rescanned as text."""
+
+    def __init__(self, src):
+        self.src = src
+        self.pending = bytearray()
+
+    def read(self, n):
+        data = bytes(self.pending[:n])
+        del self.pending[:n]
+        if len(data) < n:
+            data += self.src.read(n - len(data))
+        return data
+
+    def unread(self, data):
+        self.pending[:0] = data
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf", help="firmware ELF containing .logstr")
+    parser.add_argument("capture", nargs="?", help="UART capture file (default: stdin)")
+    parser.add_argument("-v", "--verbose", action="store_true", help="prefix file:line like LOG_VERBOSE_MODE")
+    parser.add_argument("--hz", type=int, default=25000000, help="LOG_TIMESTAMP_HZ of the firmware (default: 25000000)")
+    opts = parser.parse_args()
+
+    table, base = read_logstr(opts.elf)
+    if table is None:
+        print(f"{opts.elf}: no .logstr section, deferred frames are passed through", file=sys.stderr)
+    frames = FrameDecoder(table, base, opts)
+    src = ByteSource(open(opts.capture, "rb") if opts.capture else sys.stdin.buffer)
+    text = codecs.getincrementaldecoder("utf-8")(errors="replace")
+    out = sys.stdout
+
+    while True:
+        b = src.read(1)
+        if not b:
+            break
+        if b[0] in MAGICS:
+            length = src.read(1)
+            body = src.read(length[0]) if length else b""
+            record = frames.text(b[0], body) if length and len(body) == length[0] else None
+            if record is not None:
+                out.write(text.decode(b"", final=True) + record)
+                out.flush()
+                continue
+            # Not a frame, e.g. a UTF-8 continuation byte; rescan what followed as text
+            src.unread(length + body)
+        out.write(text.decode(b))
+    out.write(text.decode(b"", final=True))
+
+
+if __name__ == "__main__":
+    main()